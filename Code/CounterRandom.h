@@ -0,0 +1,27 @@
+// CounterRandom.h
+// Counter-based random numbers. Each number is a hash of a seed and its position in the sequence, so the n-th number can
+// be drawn directly on any thread without sharing a generator, and the sequence doesn't depend on which thread draws it.
+
+#pragma once
+#include <cstdint>
+
+// n-th number of the sequence for seed, the SplitMix64 finaliser run over the seed and counter
+inline uint64_t CounterRandom(uint64_t seed, uint64_t counter)
+{
+
+	uint64_t z = (seed * 0x9E3779B97F4A7C15ull) + ((counter + 1) * 0xD1B54A32D192ED03ull);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+	return z ^ (z >> 31);
+
+}
+
+// Maps 32 random bits onto [0, range) without the bias of a modulo
+inline int CounterRandomRange(uint32_t bits, int range)
+{
+
+	return (int)(((uint64_t)bits * (uint64_t)range) >> 32);
+
+}
@@ -0,0 +1,294 @@
+// FractalNoise.h
+// Fractional Brownian motion over rows of sample points, specialised at compile time on the noise generator,
+// the way octaves are combined (plain or ridged) and optionally the number of octaves.
+// GenerateHeightMap picks the right instantiation once per call, so the octave loop itself has no per-sample branching
+// and the weighting loops are simple enough for the compiler to unroll and vectorise.
+
+#pragma once
+#include <cmath>
+#include "ImprovedNoise.h"
+#include "SimplexNoise.h"
+
+// Parameters shared by every fBm instantiation
+struct FbmParams
+{
+
+	float offsetX, offsetZ;		// Offset applied to positions before sampling
+	float frequency;			// Frequency of the first octave, doubled for each octave after it
+	float amplitude;			// Amplitude of the first octave
+	float persistence;			// Amplitude multiplier between octaves
+	int octaves;				// Number of octaves, ignored when fixed by the Octaves template parameter
+
+};
+
+// Samplers adapt the noise generators to a common batched interface
+struct PerlinSampler
+{
+
+	ImprovedNoise* generator;
+
+	void Sample(const float* x, const float* z, float* out, int count) const
+	{
+
+		generator->noise2D(x, z, 0, out, count);
+
+	}
+
+	void SampleDual(const float* x, const float* z, float* outA, float* outB, int count) const
+	{
+
+		generator->noise2DDual(x, z, 0, 150, outA, outB, count);
+
+	}
+
+};
+
+struct SimplexSampler
+{
+
+	SimplexNoise* generator;
+
+	void Sample(const float* x, const float* z, float* out, int count) const
+	{
+
+		generator->noise2D(x, z, 0, out, count);
+
+	}
+
+	void SampleDual(const float* x, const float* z, float* outA, float* outB, int count) const
+	{
+
+		generator->noise2DDual(x, z, 0, 150, outA, outB, count);
+
+	}
+
+};
+
+// Combine policies, Combine adds one octave into the running total
+// For non-negative amplitudes Combine is exactly Accumulate applied to the unweighted Layer, which lets the layers be cached
+// and reweighted without sampling the noise again
+
+// Standard fBm, each octave adds its noise value scaled by the octave's amplitude
+struct PlainFbm
+{
+
+	static const bool Dual = false;
+
+	static void Layer(const float* noise, const float* /*noise2*/, float* layer, int count)
+	{
+
+		for (int i = 0; i < count; i++)
+		{
+
+			layer[i] = noise[i];
+
+		}
+
+	}
+
+	static void Accumulate(const float* layer, float amplitude, float* value, int count)
+	{
+
+		for (int i = 0; i < count; i++)
+		{
+
+			value[i] += layer[i] * amplitude;
+
+		}
+
+	}
+
+	static void Combine(const float* noise, const float* /*noise2*/, float amplitude, float* value, int count)
+	{
+
+		for (int i = 0; i < count; i++)
+		{
+
+			value[i] += noise[i] * amplitude;
+
+		}
+
+	}
+
+};
+
+// Simple ridged multifractal, takes the larger of two independent noise values
+// and inverts its absolute value to turn valleys into ridges
+struct RidgedFbm
+{
+
+	static const bool Dual = true;
+
+	static void Layer(const float* noise, const float* noise2, float* layer, int count)
+	{
+
+		for (int i = 0; i < count; i++)
+		{
+
+			layer[i] = fabs(noise2[i] > noise[i] ? noise2[i] : noise[i]);
+
+		}
+
+	}
+
+	static void Accumulate(const float* layer, float amplitude, float* value, int count)
+	{
+
+		for (int i = 0; i < count; i++)
+		{
+
+			value[i] -= layer[i] * amplitude;
+
+		}
+
+	}
+
+	static void Combine(const float* noise, const float* noise2, float amplitude, float* value, int count)
+	{
+
+		for (int i = 0; i < count; i++)
+		{
+
+			float ridge = noise[i] * amplitude;
+			float ridge2 = noise2[i] * amplitude;
+
+			value[i] -= fabs(ridge2 > ridge ? ridge2 : ridge);
+
+		}
+
+	}
+
+};
+
+// Evaluates fBm for rows of up to count points, Octaves = 0 takes the octave count from FbmParams at runtime
+template <class Sampler, class Policy, int Octaves = 0>
+class FbmGenerator
+{
+
+public:
+
+	FbmGenerator(const Sampler& lsampler, const FbmParams& lparams, int lcount)
+		: sampler(lsampler), params(lparams), count(lcount)
+	{
+
+		sampleX = new float[count];
+		sampleZ = new float[count];
+		noise = new float[count];
+		noise2 = new float[count];
+
+	}
+
+	~FbmGenerator()
+	{
+
+		delete[] sampleX;
+		delete[] sampleZ;
+		delete[] noise;
+		delete[] noise2;
+
+	}
+
+	int OctaveCount() const
+	{
+
+		return Octaves > 0 ? Octaves : params.octaves;
+
+	}
+
+	// Sums every octave for the points (x[i], z), positions are given before the offset and frequency are applied
+	// value is overwritten with the result
+	void Evaluate(const float* x, float z, float* value)
+	{
+
+		float amplitudeLoop = params.amplitude;
+		float frequencyLoop = params.frequency;
+
+		for (int i = 0; i < count; i++)
+		{
+
+			value[i] = 0.0f;
+
+		}
+
+		for (int k = 0; k < OctaveCount(); k++)
+		{
+
+			SampleOctave(x, z, frequencyLoop);
+
+			Policy::Combine(noise, noise2, amplitudeLoop, value, count);
+
+			// Amplitude falls off by the persistence/gain value, frequency doubles (lacunarity of 2.0)
+			amplitudeLoop *= params.persistence;
+			frequencyLoop *= 2.0f;
+
+		}
+
+	}
+
+	// Unweighted noise for a single octave, the value that Policy::Accumulate weights by the octave's amplitude
+	void EvaluateLayer(const float* x, float z, int octave, float* layer)
+	{
+
+		// Doubling is exact, so this matches the frequency Evaluate reaches for the octave
+		float frequencyLoop = params.frequency;
+
+		for (int k = 0; k < octave; k++)
+		{
+
+			frequencyLoop *= 2.0f;
+
+		}
+
+		SampleOctave(x, z, frequencyLoop);
+
+		Policy::Layer(noise, noise2, layer, count);
+
+	}
+
+private:
+
+	// Fills the noise buffers for the points (x[i], z) at the given frequency
+	void SampleOctave(const float* x, float z, float frequency)
+	{
+
+		// Work out the sample positions for this octave
+		float sz = (z + params.offsetZ) * frequency;
+
+		for (int i = 0; i < count; i++)
+		{
+
+			sampleX[i] = (x[i] + params.offsetX) * frequency;
+			sampleZ[i] = sz;
+
+		}
+
+		if (Policy::Dual)
+		{
+
+			sampler.SampleDual(sampleX, sampleZ, noise, noise2, count);
+
+		}
+		else
+		{
+
+			sampler.Sample(sampleX, sampleZ, noise, count);
+
+		}
+
+	}
+
+	Sampler sampler;
+	FbmParams params;
+	int count;
+
+	// Row buffers for the batched noise functions
+	float* sampleX;
+	float* sampleZ;
+	float* noise;
+	float* noise2;
+
+	// Owns its buffers, so copying isn't allowed
+	FbmGenerator(const FbmGenerator&);
+	FbmGenerator& operator=(const FbmGenerator&);
+
+};
@@ -0,0 +1,61 @@
+// GridBoundary.h
+// Boundary policies for the stencil passes over a HeightField.
+// The heights are stored with a one cell ghost border. Before a pass the policy fills the border in, so every vertex
+// sees a full neighbourhood and the passes run the same straight-line code on the edges as everywhere else.
+
+#pragma once
+
+// Runtime choice of boundary, HeightField picks the matching policy once per pass
+enum BoundaryMode
+{
+
+	BOUNDARY_WALL,		// Ghost cells are a wall that nothing flows into, the original behaviour
+	BOUNDARY_CLAMP,		// Ghost cells copy the nearest edge vertex
+	BOUNDARY_MIRROR,	// Ghost cells reflect the map about its edge vertices
+	BOUNDARY_WRAP		// Ghost cells copy the opposite edge, so the map tiles
+
+};
+
+// Each policy maps a coordinate up to one cell outside [0, size) to the vertex its ghost cell copies
+// Anything deposited on a ghost cell belongs to that vertex, and a droplet stepping onto it moves there
+
+struct WallBoundary
+{
+
+	static const bool isWall = true;
+	static const bool wraps = false;
+
+	// Walls don't copy anything, but droplets that climb over one stay on the edge of the map
+	static int Source(int x, int size) { return x < 0 ? 0 : (x >= size ? size - 1 : x); }
+
+};
+
+struct ClampBoundary
+{
+
+	static const bool isWall = false;
+	static const bool wraps = false;
+
+	static int Source(int x, int size) { return x < 0 ? 0 : (x >= size ? size - 1 : x); }
+
+};
+
+struct MirrorBoundary
+{
+
+	static const bool isWall = false;
+	static const bool wraps = false;
+
+	static int Source(int x, int size) { return x < 0 ? -x : (x >= size ? (2 * size) - 2 - x : x); }
+
+};
+
+struct WrapBoundary
+{
+
+	static const bool isWall = false;
+	static const bool wraps = true;
+
+	static int Source(int x, int size) { return x < 0 ? x + size : (x >= size ? x - size : x); }
+
+};
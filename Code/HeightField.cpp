@@ -0,0 +1,2810 @@
+#include "HeightField.h"
+#include "CounterRandom.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// Initialise the heightmap (flat).
+HeightField::HeightField(ImprovedNoise* perlinNoise, SimplexNoise* simplexNoise, int lresolution)
+{
+
+	int index;
+	resolution = lresolution;
+
+	// Create the structure to hold the terrain data, x and z come from the grid so only the heights are stored
+	// A ghost cell is kept on every side so stencil passes can read a full neighbourhood at the edges
+	stride = resolution + 2;
+	heightData = new float[stride * stride];
+	heights = heightData + stride + 1;
+	ghostHeights = new float[4 * (resolution + 1)];
+
+	// Initialise the data in the height map (flat).
+	for (index = 0; index < stride * stride; index++)
+	{
+
+		heightData[index] = 0.0f;
+
+	}
+
+	boundaryMode = BOUNDARY_WALL;
+
+	// Working grids are created by the passes that need them
+	swapData = 0;
+	filterData = 0;
+	smoothingDoubleBuffered = false;
+
+	thermalConvergence = false;
+	thermalTolerance = 0.0f;
+	thermalStats.iterations = 0;
+	thermalStats.cellsProcessed = 0;
+	thermalStats.maxTransfer = 0.0f;
+	ResetHydraulicStats(hydraulicStats);
+
+	// Normals are created by CalculateNormals
+	normals = 0;
+
+	perlinNoiseGen = perlinNoise;
+	simplexNoiseGen = simplexNoise;
+
+	threadPool = new ThreadPool();
+
+	layerCacheEnabled = false;
+	layerCache = 0;
+	layerCacheOctaves = 0;
+
+	scrollEnabled = false;
+	scrollValid = false;
+	scrollCellsX = 0;
+	scrollCellsZ = 0;
+
+}
+
+// Release resources.
+HeightField::~HeightField()
+{
+
+	delete threadPool;
+	delete[] layerCache;
+	delete[] heightData;
+	delete[] ghostHeights;
+	delete[] swapData;
+	delete[] filterData;
+	delete[] normals;
+
+}
+
+int HeightField::GetResolution() const
+{
+
+	return resolution;
+
+}
+
+float HeightField::PositionX(int i) const
+{
+
+	return (float)i / (0.01 * resolution);
+
+}
+
+float HeightField::PositionZ(int j) const
+{
+
+	return (float)j / (0.01 * resolution);
+
+}
+
+float* HeightField::GetHeights()
+{
+
+	return heights;
+
+}
+
+const float* HeightField::GetHeights() const
+{
+
+	return heights;
+
+}
+
+int HeightField::GetStride() const
+{
+
+	return stride;
+
+}
+
+const HeightField::VectorType* HeightField::GetNormals() const
+{
+
+	return normals;
+
+}
+
+void HeightField::SetThreadCount(int threadCount)
+{
+
+	delete threadPool;
+	threadPool = new ThreadPool(threadCount);
+
+}
+
+int HeightField::GetThreadCount() const
+{
+
+	return threadPool->GetThreadCount();
+
+}
+
+void HeightField::SetLayerCacheEnabled(bool enabled)
+{
+
+	layerCacheEnabled = enabled;
+
+	if (enabled == false)
+	{
+
+		delete[] layerCache;
+		layerCache = 0;
+		layerCacheOctaves = 0;
+
+	}
+
+}
+
+void HeightField::SetScrollEnabled(bool enabled)
+{
+
+	scrollEnabled = enabled;
+
+}
+
+void HeightField::SetBoundaryMode(BoundaryMode mode)
+{
+
+	boundaryMode = mode;
+
+}
+
+BoundaryMode HeightField::GetBoundaryMode() const
+{
+
+	return boundaryMode;
+
+}
+
+void HeightField::SetSmoothingDoubleBuffered(bool enabled)
+{
+
+	smoothingDoubleBuffered = enabled;
+
+}
+
+float* HeightField::CreateGrid() const
+{
+
+	float* grid = new float[stride * stride];
+
+	for (int index = 0; index < stride * stride; index++)
+	{
+
+		grid[index] = 0.0f;
+
+	}
+
+	return grid;
+
+}
+
+void HeightField::SwapHeights()
+{
+
+	if (swapData == 0)
+	{
+
+		swapData = CreateGrid();
+
+	}
+
+	std::swap(heightData, swapData);
+	heights = heightData + stride + 1;
+
+}
+
+int HeightField::RowsPerBlock(int rows) const
+{
+
+	// Aim for a few blocks per thread to even out the load
+	return rows / (threadPool->GetThreadCount() * 4);
+
+}
+
+void HeightField::GenerateHeightMap(float offsetX, float offsetZ, float frequency, float amplitude, bool ridged, bool simplex, 
+	int octaves, float persistence, float offsetY)
+{
+
+	FbmParams params = { offsetX, offsetZ, frequency, amplitude, persistence, octaves };
+
+	// Cached layers are only any use if the noise they were sampled from hasn't changed
+	LayerCacheKey key = { offsetX, offsetZ, frequency, simplex, ridged, resolution };
+
+	if (layerCacheOctaves > 0 && (key.offsetX != layerCacheKey.offsetX || key.offsetZ != layerCacheKey.offsetZ ||
+		key.frequency != layerCacheKey.frequency || key.simplex != layerCacheKey.simplex || key.ridged != layerCacheKey.ridged ||
+		key.resolution != layerCacheKey.resolution))
+	{
+
+		layerCacheOctaves = 0;
+
+	}
+
+	layerCacheKey = key;
+
+	// Work out which parts of the heightmap need sampling, either everything or just the strips a scroll uncovers
+	HeightMapRegion regions[2];
+	int regionCount = 0;
+	int shiftX, shiftZ;
+	bool scrolled = scrollEnabled == true && scrollValid == true &&
+		FindScrollShift(params, simplex, ridged, offsetY, shiftX, shiftZ) == true;
+
+	if (scrolled == true)
+	{
+
+		ShiftHeightMap(shiftX, shiftZ);
+
+		// The heights that stay are exactly a whole number of cells on from the last full rebuild, which can be a little
+		// off the offsets asked for, so the new strips are sampled there too rather than where they were asked for
+		float spacing = 100.0f / resolution;
+		scrollCellsX += shiftX;
+		scrollCellsZ += shiftZ;
+		params.offsetX = scrollParams.offsetX + (scrollCellsX * spacing);
+		params.offsetZ = scrollParams.offsetZ + (scrollCellsZ * spacing);
+
+		// Whole rows uncovered along the top or bottom edge
+		int rowBegin = shiftZ > 0 ? resolution - shiftZ : 0;
+		int rowEnd = shiftZ > 0 ? resolution : -shiftZ;
+
+		if (rowEnd > rowBegin)
+		{
+
+			HeightMapRegion rows = { rowBegin, rowEnd, 0, resolution };
+			regions[regionCount++] = rows;
+
+		}
+
+		// Partial columns uncovered along the left or right edge, between those rows
+		int columnBegin = shiftX > 0 ? resolution - shiftX : 0;
+		int columnEnd = shiftX > 0 ? resolution : -shiftX;
+
+		if (columnEnd > columnBegin)
+		{
+
+			HeightMapRegion columns = { shiftZ < 0 ? -shiftZ : 0, shiftZ > 0 ? resolution - shiftZ : resolution, columnBegin, columnEnd };
+			regions[regionCount++] = columns;
+
+		}
+
+	}
+	else
+	{
+
+		HeightMapRegion all = { 0, resolution, 0, resolution };
+		regions[regionCount++] = all;
+
+	}
+
+	// Pick the specialised fBm generator once, rather than checking which noise and which combination
+	// of octaves to use for every sample of every octave
+	if (simplex == true)
+	{
+
+		SimplexSampler sampler = { simplexNoiseGen };
+
+		if (ridged == true)
+		{
+
+			GenerateHeightMapFbm<SimplexSampler, RidgedFbm>(sampler, params, offsetY, regions, regionCount);
+
+		}
+		else
+		{
+
+			GenerateHeightMapFbm<SimplexSampler, PlainFbm>(sampler, params, offsetY, regions, regionCount);
+
+		}
+
+	}
+	else
+	{
+
+		PerlinSampler sampler = { perlinNoiseGen };
+
+		if (ridged == true)
+		{
+
+			GenerateHeightMapFbm<PerlinSampler, RidgedFbm>(sampler, params, offsetY, regions, regionCount);
+
+		}
+		else
+		{
+
+			GenerateHeightMapFbm<PerlinSampler, PlainFbm>(sampler, params, offsetY, regions, regionCount);
+
+		}
+
+	}
+
+	// Remember what this heightmap was generated with, so the next call can tell whether it's a scroll
+	// A scroll keeps the offsets of the last full rebuild, so snapping each pan to whole cells never adds up
+	if (scrolled == false)
+	{
+
+		scrollParams = params;
+		scrollCellsX = 0;
+		scrollCellsZ = 0;
+
+	}
+
+	scrollValid = true;
+	scrollOffsetY = offsetY;
+	scrollSimplex = simplex;
+	scrollRidged = ridged;
+
+}
+
+bool HeightField::FindScrollShift(const FbmParams& params, bool simplex, bool ridged, float offsetY, int& shiftX, int& shiftZ)
+{
+
+	// Anything other than the offsets changing changes every height
+	if (params.frequency != scrollParams.frequency || params.amplitude != scrollParams.amplitude ||
+		params.persistence != scrollParams.persistence || params.octaves != scrollParams.octaves ||
+		offsetY != scrollOffsetY || simplex != scrollSimplex || ridged != scrollRidged)
+	{
+
+		return false;
+
+	}
+
+	// The offsets have to have moved by a whole number of cells for the old heights to line up with the new vertices
+	// Measuring from the last full rebuild rather than the last scroll keeps each pan's snapping from adding to the next's
+	float spacing = 100.0f / resolution;
+	float cellsX = (params.offsetX - scrollParams.offsetX) / spacing;
+	float cellsZ = (params.offsetZ - scrollParams.offsetZ) / spacing;
+
+	int totalX = (int)floor(cellsX + 0.5f);
+	int totalZ = (int)floor(cellsZ + 0.5f);
+
+	if (fabs(cellsX - totalX) > SCROLL_CELL_TOLERANCE || fabs(cellsZ - totalZ) > SCROLL_CELL_TOLERANCE)
+	{
+
+		return false;
+
+	}
+
+	shiftX = totalX - scrollCellsX;
+	shiftZ = totalZ - scrollCellsZ;
+
+	// Nothing would be left to reuse
+	if (abs(shiftX) >= resolution || abs(shiftZ) >= resolution)
+	{
+
+		return false;
+
+	}
+
+	return true;
+
+}
+
+void HeightField::ShiftHeightMap(int shiftX, int shiftZ)
+{
+
+	// The vertex at (i, j) takes the height from (i + shiftX, j + shiftZ), which is a fixed distance through the array.
+	// Walking in the same direction as that distance reads every height before it gets overwritten
+	int shift = (stride * shiftZ) + shiftX;
+
+	int columnBegin = shiftX < 0 ? -shiftX : 0;
+	int columnEnd = shiftX > 0 ? resolution - shiftX : resolution;
+	int rowBegin = shiftZ < 0 ? -shiftZ : 0;
+	int rowEnd = shiftZ > 0 ? resolution - shiftZ : resolution;
+
+	if (shift > 0)
+	{
+
+		for (int j = rowBegin; j < rowEnd; j++)
+		{
+
+			for (int i = columnBegin; i < columnEnd; i++)
+			{
+
+				int index = (stride * j) + i;
+				heights[index] = heights[index + shift];
+
+			}
+
+		}
+
+	}
+	else if (shift < 0)
+	{
+
+		for (int j = rowEnd - 1; j >= rowBegin; j--)
+		{
+
+			for (int i = columnEnd - 1; i >= columnBegin; i--)
+			{
+
+				int index = (stride * j) + i;
+				heights[index] = heights[index + shift];
+
+			}
+
+		}
+
+	}
+
+}
+
+template <class Sampler, class Policy>
+void HeightField::GenerateHeightMapFbm(const Sampler& sampler, const FbmParams& params, float offsetY,
+	const HeightMapRegion* regions, int regionCount)
+{
+
+	// Reweighting the layers only matches summing the octaves directly while every octave's amplitude is non-negative
+	// The layers always cover the whole map, so they're only used for full rebuilds
+	bool wholeMap = regionCount == 1 && regions[0].rowBegin == 0 && regions[0].rowEnd == resolution &&
+		regions[0].columnBegin == 0 && regions[0].columnEnd == resolution;
+
+	if (layerCacheEnabled == true && wholeMap == true && params.amplitude >= 0.0f && params.persistence >= 0.0f)
+	{
+
+		GenerateHeightMapCached<Sampler, Policy>(sampler, params, offsetY);
+		return;
+
+	}
+
+	for (int r = 0; r < regionCount; r++)
+	{
+
+		// 8 octaves is by far the most common setting, so give it a version with a fixed loop count
+		if (params.octaves == 8)
+		{
+
+			GenerateHeightMapRows<Sampler, Policy, 8>(sampler, params, offsetY, regions[r]);
+
+		}
+		else
+		{
+
+			GenerateHeightMapRows<Sampler, Policy, 0>(sampler, params, offsetY, regions[r]);
+
+		}
+
+	}
+
+}
+
+template <class Sampler, class Policy, int Octaves>
+void HeightField::GenerateHeightMapRows(const Sampler& sampler, const FbmParams& params, float offsetY, const HeightMapRegion& region)
+{
+
+	int columns = region.columnEnd - region.columnBegin;
+
+	// Every row shares the same x positions
+	float* columnX = new float[columns];
+
+	for (int i = 0; i < columns; i++)
+	{
+
+		columnX[i] = PositionX(region.columnBegin + i);
+
+	}
+
+	// Each row only depends on its own z position, so blocks of rows can be handed out to any thread
+	// and the result doesn't depend on how many there are
+	threadPool->ParallelFor(region.rowEnd - region.rowBegin, RowsPerBlock(region.rowEnd - region.rowBegin), [&](int blockBegin, int blockEnd)
+	{
+
+		int index;	// Index of current vertex
+
+		FbmGenerator<Sampler, Policy, Octaves> fbm(sampler, params, columns);
+		float* value = new float[columns];
+
+		for (int j = region.rowBegin + blockBegin; j < region.rowBegin + blockEnd; j++)
+		{
+
+			fbm.Evaluate(columnX, PositionZ(j), value);
+
+			// Update the vertices' heights
+			for (int i = 0; i < columns; i++)
+			{
+
+				index = (stride * j) + region.columnBegin + i;
+
+				heights[index] = offsetY + value[i];
+
+			}
+
+		}
+
+		delete[] value;
+
+	});
+
+	delete[] columnX;
+
+}
+
+template <class Sampler, class Policy>
+void HeightField::GenerateHeightMapCached(const Sampler& sampler, const FbmParams& params, float offsetY)
+{
+
+	int layerSize = resolution * resolution;
+
+	// Sample any octaves past the ones already cached
+	if (layerCacheOctaves < params.octaves)
+	{
+
+		float* layers = new float[params.octaves * layerSize];
+
+		if (layerCache != 0)
+		{
+
+			memcpy(layers, layerCache, layerCacheOctaves * layerSize * sizeof(float));
+			delete[] layerCache;
+
+		}
+
+		layerCache = layers;
+
+		float* columnX = new float[resolution];
+
+		for (int i = 0; i < resolution; i++)
+		{
+
+			columnX[i] = PositionX(i);
+
+		}
+
+		threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+		{
+
+			FbmGenerator<Sampler, Policy> fbm(sampler, params, resolution);
+
+			for (int k = layerCacheOctaves; k < params.octaves; k++)
+			{
+
+				for (int j = rowBegin; j < rowEnd; j++)
+				{
+
+					fbm.EvaluateLayer(columnX, PositionZ(j), k, layerCache + (k * layerSize) + (resolution * j));
+
+				}
+
+			}
+
+		});
+
+		delete[] columnX;
+
+		layerCacheOctaves = params.octaves;
+
+	}
+
+	// Weight and sum the layers, in the same order as the octaves are added up when sampling directly
+	threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+	{
+
+		int index;	// Index of current vertex
+
+		float* value = new float[resolution];
+
+		for (int j = rowBegin; j < rowEnd; j++)
+		{
+
+			float amplitudeLoop = params.amplitude;
+
+			for (int i = 0; i < resolution; i++)
+			{
+
+				value[i] = 0.0f;
+
+			}
+
+			for (int k = 0; k < params.octaves; k++)
+			{
+
+				Policy::Accumulate(layerCache + (k * layerSize) + (resolution * j), amplitudeLoop, value, resolution);
+
+				amplitudeLoop *= params.persistence;
+
+			}
+
+			for (int i = 0; i < resolution; i++)
+			{
+
+				index = (stride * j) + i;
+
+				heights[index] = offsetY + value[i];
+
+			}
+
+		}
+
+		delete[] value;
+
+	});
+
+}
+
+template <class Boundary>
+void HeightField::FillGhostCells(float* grid, float wallValue)
+{
+
+	int ghost = 0;
+
+	// Ghost rows below and above the map, including the corners
+	for (int i = -1; i <= resolution; i++)
+	{
+
+		int column = Boundary::Source(i, resolution);
+
+		ghostHeights[ghost++] = grid[-stride + i] = Boundary::isWall ? wallValue : grid[(stride * Boundary::Source(-1, resolution)) + column];
+		ghostHeights[ghost++] = grid[(stride * resolution) + i] = Boundary::isWall ? wallValue : grid[(stride * Boundary::Source(resolution, resolution)) + column];
+
+	}
+
+	// Ghost columns either side of the map
+	for (int j = 0; j < resolution; j++)
+	{
+
+		ghostHeights[ghost++] = grid[(stride * j) - 1] = Boundary::isWall ? wallValue : grid[(stride * j) + Boundary::Source(-1, resolution)];
+		ghostHeights[ghost++] = grid[(stride * j) + resolution] = Boundary::isWall ? wallValue : grid[(stride * j) + Boundary::Source(resolution, resolution)];
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::FoldGhostCells()
+{
+
+	// Whatever lands on a wall is lost
+	if (Boundary::isWall)
+	{
+
+		return;
+
+	}
+
+	// Walk the ghost cells in the same order FillGhostCells did
+	int ghost = 0;
+
+	for (int i = -1; i <= resolution; i++)
+	{
+
+		int column = Boundary::Source(i, resolution);
+
+		heights[(stride * Boundary::Source(-1, resolution)) + column] += heights[-stride + i] - ghostHeights[ghost++];
+		heights[(stride * Boundary::Source(resolution, resolution)) + column] += heights[(stride * resolution) + i] - ghostHeights[ghost++];
+
+	}
+
+	for (int j = 0; j < resolution; j++)
+	{
+
+		heights[(stride * j) + Boundary::Source(-1, resolution)] += heights[(stride * j) - 1] - ghostHeights[ghost++];
+		heights[(stride * j) + Boundary::Source(resolution, resolution)] += heights[(stride * j) + resolution] - ghostHeights[ghost++];
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::RefreshGhostCells(int i, int j)
+{
+
+	if (Boundary::isWall)
+	{
+
+		return;
+
+	}
+
+	// Only the edge ghost cells are refreshed, the corners are never read as a von Neumann neighbour
+	float height = heights[(stride * j) + i];
+
+	if (Boundary::Source(-1, resolution) == i)
+	{
+
+		heights[(stride * j) - 1] = height;
+
+	}
+
+	if (Boundary::Source(resolution, resolution) == i)
+	{
+
+		heights[(stride * j) + resolution] = height;
+
+	}
+
+	if (Boundary::Source(-1, resolution) == j)
+	{
+
+		heights[-stride + i] = height;
+
+	}
+
+	if (Boundary::Source(resolution, resolution) == j)
+	{
+
+		heights[(stride * resolution) + i] = height;
+
+	}
+
+}
+
+void HeightField::SmoothingFunction(float smoothingWeight, float upperBound, float lowerBound)
+{
+
+	// The heights no longer come straight from the noise, so they can't be scrolled
+	scrollValid = false;
+
+	switch (boundaryMode)
+	{
+
+	case BOUNDARY_CLAMP:
+		SmoothingPass<ClampBoundary>(smoothingWeight, upperBound, lowerBound);
+		break;
+
+	case BOUNDARY_MIRROR:
+		SmoothingPass<MirrorBoundary>(smoothingWeight, upperBound, lowerBound);
+		break;
+
+	case BOUNDARY_WRAP:
+		SmoothingPass<WrapBoundary>(smoothingWeight, upperBound, lowerBound);
+		break;
+
+	default:
+		SmoothingPass<WallBoundary>(smoothingWeight, upperBound, lowerBound);
+		break;
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::SmoothingPass(float smoothingWeight, float upperBound, float lowerBound)
+{
+
+	if (smoothingDoubleBuffered == true)
+	{
+
+		SmoothingPassDoubleBuffered<Boundary>(smoothingWeight, upperBound, lowerBound);
+		return;
+
+	}
+
+	// Nothing lies beyond a wall, so vertices next to one only average the neighbours they have
+	// Zero walls add nothing to the sum, and the neighbour count below leaves them out of the average
+	FillGhostCells<Boundary>(heights, 0.0f);
+
+	// Working values
+	int index;									// Index of current vertex
+	float v1, v2, v3, v4, v5, v6, v7, v8, v9;	// Current vertex v2 and its Moore neighbourhood
+
+	// Loop vertically
+	for (int j = 0; j < resolution; j++)
+	{
+
+		// Number of rows in the neighbourhood that are on the map
+		int rows = 3 - (j == 0) - (j == resolution - 1);
+
+		// Loop horizontally
+		for (int i = 0; i < resolution; i++)
+		{
+
+			// Calculate the position of the vertex we need to access within the heightmap
+			index = (stride * j) + i;
+
+			v1 = heights[index - 1];
+			v2 = heights[index];
+			v3 = heights[index + 1];
+			v4 = heights[index + stride - 1];
+			v5 = heights[index + stride];
+			v6 = heights[index + stride + 1];
+			v7 = heights[index - stride - 1];
+			v8 = heights[index - stride];
+			v9 = heights[index - stride + 1];
+
+			float neighbours = Boundary::isWall ? (float)((rows * (3 - (i == 0) - (i == resolution - 1))) - 1) : 8.0f;
+			float smoothed = (v2 * (1 - smoothingWeight)) + (((v1 + v3 + v4 + v5 + v6 + v7 + v8 + v9) / neighbours) * smoothingWeight);
+
+			// Only smooth vertices within the height bounds
+			heights[index] = (v2 < upperBound && v2 > lowerBound) ? smoothed : v2;
+
+		}
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::SmoothingPassDoubleBuffered(float smoothingWeight, float upperBound, float lowerBound)
+{
+
+	FillGhostCells<Boundary>(heights, 0.0f);
+
+	if (swapData == 0)
+	{
+
+		swapData = CreateGrid();
+
+	}
+
+	const float* source = heights;
+	float* destination = swapData + stride + 1;
+
+	// Number of columns in each vertex's neighbourhood that are on the map, for averaging next to a wall
+	float* columns = new float[resolution];
+
+	for (int i = 0; i < resolution; i++)
+	{
+
+		columns[i] = (float)(3 - (i == 0) - (i == resolution - 1));
+
+	}
+
+	// Every vertex only reads the old heights, so rows can be smoothed in any order on any thread
+	threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+	{
+
+		for (int j = rowBegin; j < rowEnd; j++)
+		{
+
+			float rows = (float)(3 - (j == 0) - (j == resolution - 1));
+
+			const float* centre = source + (stride * j);
+			const float* above = centre + stride;
+			const float* below = centre - stride;
+			float* result = destination + (stride * j);
+
+			// Straight-line loop over the row, so the compiler can vectorise it
+			for (int i = 0; i < resolution; i++)
+			{
+
+				float v2 = centre[i];
+				float sum = centre[i - 1] + centre[i + 1] + above[i - 1] + above[i] + above[i + 1] + below[i - 1] + below[i] + below[i + 1];
+				float neighbours = Boundary::isWall ? (rows * columns[i]) - 1.0f : 8.0f;
+				float smoothed = (v2 * (1 - smoothingWeight)) + ((sum / neighbours) * smoothingWeight);
+
+				// Only smooth vertices within the height bounds
+				result[i] = (v2 < upperBound && v2 > lowerBound) ? smoothed : v2;
+
+			}
+
+		}
+
+	});
+
+	delete[] columns;
+
+	SwapHeights();
+
+}
+
+void HeightField::SeparableSmoothing(SmoothingFilter filter, int radius, int passes, float smoothingWeight, float upperBound, float lowerBound)
+{
+
+	// The heights no longer come straight from the noise, so they can't be scrolled
+	scrollValid = false;
+
+	// The boundaries can only reflect or wrap a window that fits on the map
+	radius = std::min(radius, resolution - 1);
+
+	if (radius < 1)
+	{
+
+		return;
+
+	}
+
+	switch (boundaryMode)
+	{
+
+	case BOUNDARY_CLAMP:
+		SeparableSmoothingPass<ClampBoundary>(filter, radius, passes, smoothingWeight, upperBound, lowerBound);
+		break;
+
+	case BOUNDARY_MIRROR:
+		SeparableSmoothingPass<MirrorBoundary>(filter, radius, passes, smoothingWeight, upperBound, lowerBound);
+		break;
+
+	case BOUNDARY_WRAP:
+		SeparableSmoothingPass<WrapBoundary>(filter, radius, passes, smoothingWeight, upperBound, lowerBound);
+		break;
+
+	default:
+		SeparableSmoothingPass<WallBoundary>(filter, radius, passes, smoothingWeight, upperBound, lowerBound);
+		break;
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::SeparableSmoothingPass(SmoothingFilter filter, int radius, int passes, float smoothingWeight, float upperBound, float lowerBound)
+{
+
+	if (swapData == 0)
+	{
+
+		swapData = CreateGrid();
+
+	}
+
+	if (filterData == 0)
+	{
+
+		filterData = CreateGrid();
+
+	}
+
+	// Rows are filtered into one working grid and columns into the other
+	float* filteredRows = swapData + stride + 1;
+	float* filtered = filterData + stride + 1;
+
+	int boxes = filter == SMOOTHING_GAUSSIAN ? 3 : 1;
+
+	for (int pass = 0; pass < passes; pass++)
+	{
+
+		const float* source = heights;
+
+		for (int box = 0; box < boxes; box++)
+		{
+
+			BoxFilterRows<Boundary>(source, filteredRows, radius);
+			BoxFilterColumns<Boundary>(filteredRows, filtered, radius);
+
+			source = filtered;
+
+		}
+
+		// Blend the vertices within the height bounds towards the filtered terrain
+		threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+		{
+
+			for (int j = rowBegin; j < rowEnd; j++)
+			{
+
+				float* row = heights + (stride * j);
+				const float* filteredRow = filtered + (stride * j);
+
+				for (int i = 0; i < resolution; i++)
+				{
+
+					float v2 = row[i];
+					float smoothed = (v2 * (1 - smoothingWeight)) + (filteredRow[i] * smoothingWeight);
+
+					row[i] = (v2 < upperBound && v2 > lowerBound) ? smoothed : v2;
+
+				}
+
+			}
+
+		});
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::BoxFilterRows(const float* source, float* destination, int radius)
+{
+
+	threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+	{
+
+		// The row with radius vertices of boundary either side, so the window never needs checking against the edges
+		// One spare float on the end is read by the slide after the last vertex
+		float* line = new float[resolution + (2 * radius) + 1] + radius;
+		line[resolution + radius] = 0.0f;
+
+		for (int j = rowBegin; j < rowEnd; j++)
+		{
+
+			const float* row = source + (stride * j);
+
+			memcpy(line, row, resolution * sizeof(float));
+
+			// Nothing beyond a wall is averaged in, so it adds nothing to the sum
+			for (int k = 1; k <= radius; k++)
+			{
+
+				line[-k] = Boundary::isWall ? 0.0f : row[Boundary::Source(-k, resolution)];
+				line[resolution - 1 + k] = Boundary::isWall ? 0.0f : row[Boundary::Source(resolution - 1 + k, resolution)];
+
+			}
+
+			// Slide a running sum along the row, kept in double so it doesn't drift over long rows
+			double sum = 0.0;
+
+			for (int k = -radius; k <= radius; k++)
+			{
+
+				sum += line[k];
+
+			}
+
+			float* result = destination + (stride * j);
+
+			for (int i = 0; i < resolution; i++)
+			{
+
+				int count = Boundary::isWall ? std::min(i + radius, resolution - 1) - std::max(i - radius, 0) + 1 : (2 * radius) + 1;
+
+				result[i] = (float)(sum / count);
+				sum += line[i + radius + 1] - line[i - radius];
+
+			}
+
+		}
+
+		delete[] (line - radius);
+
+	});
+
+}
+
+template <class Boundary>
+void HeightField::BoxFilterColumns(const float* source, float* destination, int radius)
+{
+
+	// Columns are handed out in blocks, and each block walks down the rows keeping a running sum for every column
+	// so it reads whole stretches of each row rather than one float from each
+	int blockSize = std::max(resolution / (threadPool->GetThreadCount() * 4), 16);
+
+	threadPool->ParallelFor(resolution, blockSize, [&](int columnBegin, int columnEnd)
+	{
+
+		int columns = columnEnd - columnBegin;
+		double* sum = new double[columns];
+
+		// Row j of the source, null for rows beyond a wall as they add nothing to the sum
+		auto sourceRow = [&](int j) -> const float*
+		{
+
+			if (Boundary::isWall && (j < 0 || j >= resolution))
+			{
+
+				return 0;
+
+			}
+
+			return source + (stride * Boundary::Source(j, resolution)) + columnBegin;
+
+		};
+
+		for (int i = 0; i < columns; i++)
+		{
+
+			sum[i] = 0.0;
+
+		}
+
+		for (int k = -radius; k <= radius; k++)
+		{
+
+			const float* row = sourceRow(k);
+
+			if (row != 0)
+			{
+
+				for (int i = 0; i < columns; i++)
+				{
+
+					sum[i] += row[i];
+
+				}
+
+			}
+
+		}
+
+		for (int j = 0; j < resolution; j++)
+		{
+
+			int count = Boundary::isWall ? std::min(j + radius, resolution - 1) - std::max(j - radius, 0) + 1 : (2 * radius) + 1;
+			float* result = destination + (stride * j) + columnBegin;
+
+			for (int i = 0; i < columns; i++)
+			{
+
+				result[i] = (float)(sum[i] / count);
+
+			}
+
+			if (j == resolution - 1)
+			{
+
+				break;
+
+			}
+
+			// Slide the window down a row
+			const float* entering = sourceRow(j + radius + 1);
+			const float* leaving = sourceRow(j - radius);
+
+			if (entering != 0)
+			{
+
+				for (int i = 0; i < columns; i++)
+				{
+
+					sum[i] += entering[i];
+
+				}
+
+			}
+
+			if (leaving != 0)
+			{
+
+				for (int i = 0; i < columns; i++)
+				{
+
+					sum[i] -= leaving[i];
+
+				}
+
+			}
+
+		}
+
+		delete[] sum;
+
+	});
+
+}
+
+float HeightField::DepositSediment(float c, float maxDiff, float talus, float distance, float totalDiff)
+{
+
+	// Make sure that the distance is greater than the talus angle/threshold, else deposit nothing
+	return distance > talus ? c * (maxDiff - talus) * (distance / totalDiff) : 0.0f;
+
+}
+
+void HeightField::ThermalErosion(int erosionIterations)
+{
+
+	// The heights no longer come straight from the noise, so they can't be scrolled
+	scrollValid = false;
+
+	switch (boundaryMode)
+	{
+
+	case BOUNDARY_CLAMP:
+		ThermalErosionPass<ClampBoundary>(erosionIterations);
+		break;
+
+	case BOUNDARY_MIRROR:
+		ThermalErosionPass<MirrorBoundary>(erosionIterations);
+		break;
+
+	case BOUNDARY_WRAP:
+		ThermalErosionPass<WrapBoundary>(erosionIterations);
+		break;
+
+	default:
+		ThermalErosionPass<WallBoundary>(erosionIterations);
+		break;
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::ThermalErosionPass(int erosionIterations)
+{
+
+	// Initialise working values
+	int index;									// Index of the current vertex
+	float v1, v2, v3, v4, v5, v6, v7, v8, v9;	// Vertex v2 and its Moore neighbourhood
+	float d1, d2, d3, d4, d5, d6, d7, d8;		// Differences in height for each neighbour
+	float e1, e2, e3, e4, e5, e6, e7, e8;		// Differences steep enough to erode, 0 otherwise
+	float talus = 4.0f / resolution;			// Calculate a reasonable talus angle
+	float c = 0.5f;								// Constant C
+	float maxDiff = 0.0f;
+	float totalDiff = 0.0f;
+
+	// Loop for desired iterations
+	for (int k = 0; k < erosionIterations; k++)
+	{
+
+		// A wall is higher than anything on the map, so no material slides into it
+		FillGhostCells<Boundary>(heights, FLT_MAX);
+
+		// Loop vertically
+		for (int j = 0; j < resolution; j++)
+		{
+
+			// Loop horizontally
+			for (int i = 0; i < resolution; i++)
+			{
+
+				// Calculate the position of the vertex we need to access within the heightmap
+				index = (stride * j) + i;
+
+				// Get ith vertex (h) and its neighbours, the ghost border covers the ones off the edge of the map
+				v1 = heights[index - 1];
+				v2 = heights[index];
+				v3 = heights[index + 1];
+				v4 = heights[index + stride - 1];
+				v5 = heights[index + stride];
+				v6 = heights[index + stride + 1];
+				v7 = heights[index - stride - 1];
+				v8 = heights[index - stride];
+				v9 = heights[index - stride + 1];
+
+				// Calculate the differences of the heights between each vertex
+				d1 = v2 - v1;
+				d2 = v2 - v3;
+				d3 = v2 - v4;
+				d4 = v2 - v5;
+				d5 = v2 - v6;
+				d6 = v2 - v7;
+				d7 = v2 - v8;
+				d8 = v2 - v9;
+
+				// Get the maximum height and total height of the differences above the talus angle
+				e1 = d1 > talus ? d1 : 0.0f;
+				e2 = d2 > talus ? d2 : 0.0f;
+				e3 = d3 > talus ? d3 : 0.0f;
+				e4 = d4 > talus ? d4 : 0.0f;
+				e5 = d5 > talus ? d5 : 0.0f;
+				e6 = d6 > talus ? d6 : 0.0f;
+				e7 = d7 > talus ? d7 : 0.0f;
+				e8 = d8 > talus ? d8 : 0.0f;
+
+				totalDiff = e1 + e2 + e3 + e4 + e5 + e6 + e7 + e8;
+				maxDiff = std::max(std::max(std::max(e1, e2), std::max(e3, e4)), std::max(std::max(e5, e6), std::max(e7, e8)));
+
+				// Assign new height values for relevant vertices hi
+				heights[index - 1] += DepositSediment(c, maxDiff, talus, d1, totalDiff);
+				heights[index + 1] += DepositSediment(c, maxDiff, talus, d2, totalDiff);
+				heights[index + stride - 1] += DepositSediment(c, maxDiff, talus, d3, totalDiff);
+				heights[index + stride] += DepositSediment(c, maxDiff, talus, d4, totalDiff);
+				heights[index + stride + 1] += DepositSediment(c, maxDiff, talus, d5, totalDiff);
+				heights[index - stride - 1] += DepositSediment(c, maxDiff, talus, d6, totalDiff);
+				heights[index - stride] += DepositSediment(c, maxDiff, talus, d7, totalDiff);
+				heights[index - stride + 1] += DepositSediment(c, maxDiff, talus, d8, totalDiff);
+
+			}
+
+		}
+
+		// Material that slid off the edge lands on the vertices the ghost cells copy
+		FoldGhostCells<Boundary>();
+
+	}
+
+}
+
+void HeightField::SetThermalErosionConvergence(bool enabled, float tolerance)
+{
+
+	thermalConvergence = enabled;
+	thermalTolerance = tolerance;
+
+}
+
+const HeightField::ThermalErosionStats& HeightField::GetThermalErosionStats() const
+{
+
+	return thermalStats;
+
+}
+
+void HeightField::ParallelThermalErosion(int erosionIterations)
+{
+
+	// The heights no longer come straight from the noise, so they can't be scrolled
+	scrollValid = false;
+
+	if (boundaryMode == BOUNDARY_WRAP)
+	{
+
+		ParallelThermalErosionPass<WrapBoundary>(erosionIterations);
+
+	}
+	else
+	{
+
+		ParallelThermalErosionPass<WallBoundary>(erosionIterations);
+
+	}
+
+}
+
+bool HeightField::ThermalOutflowRow(int j, int columnBegin, int columnEnd, float talus, float c, float* outflow)
+{
+
+	const float* centre = heights + (stride * j);
+	const float* above = centre + stride;
+	const float* below = centre - stride;
+	float* result = outflow + (stride * j);
+
+	for (int i = columnBegin; i < columnEnd; i++)
+	{
+
+		float h = centre[i];
+
+		// Differences steep enough to erode, 0 otherwise
+		float d1 = h - centre[i - 1];
+		float d2 = h - centre[i + 1];
+		float d3 = h - above[i - 1];
+		float d4 = h - above[i];
+		float d5 = h - above[i + 1];
+		float d6 = h - below[i - 1];
+		float d7 = h - below[i];
+		float d8 = h - below[i + 1];
+
+		float e1 = d1 > talus ? d1 : 0.0f;
+		float e2 = d2 > talus ? d2 : 0.0f;
+		float e3 = d3 > talus ? d3 : 0.0f;
+		float e4 = d4 > talus ? d4 : 0.0f;
+		float e5 = d5 > talus ? d5 : 0.0f;
+		float e6 = d6 > talus ? d6 : 0.0f;
+		float e7 = d7 > talus ? d7 : 0.0f;
+		float e8 = d8 > talus ? d8 : 0.0f;
+
+		float totalDiff = e1 + e2 + e3 + e4 + e5 + e6 + e7 + e8;
+		float maxDiff = std::max(std::max(std::max(d1, d2), std::max(d3, d4)), std::max(std::max(d5, d6), std::max(d7, d8)));
+
+		// The steepest drop sheds c * (maxDiff - talus) in total, shared out in proportion to each drop
+		// Vertices with no drop past the talus angle come out negative and shed nothing, which keeps the loop
+		// free of branches so it can be vectorised
+		result[i] = std::max((c * (maxDiff - talus)) / std::max(totalDiff, talus), 0.0f);
+
+	}
+
+	// Checked in a second loop so the one above stays free of branches and can be vectorised
+	for (int i = columnBegin; i < columnEnd; i++)
+	{
+
+		if (result[i] > 0.0f)
+		{
+
+			return true;
+
+		}
+
+	}
+
+	return false;
+
+}
+
+float HeightField::ThermalGatherRow(int j, int columnBegin, int columnEnd, float talus, const float* outflow, float* destination)
+{
+
+	const float* centre = heights + (stride * j);
+	const float* above = centre + stride;
+	const float* below = centre - stride;
+	const float* shed = outflow + (stride * j);
+	const float* shedAbove = shed + stride;
+	const float* shedBelow = shed - stride;
+	float* result = destination + (stride * j);
+
+	for (int i = columnBegin; i < columnEnd; i++)
+	{
+
+		float h = centre[i];
+		float s = shed[i];
+
+		// Height differences to each neighbour, positive where the neighbour is lower
+		float d1 = h - centre[i - 1];
+		float d2 = h - centre[i + 1];
+		float d3 = h - above[i - 1];
+		float d4 = h - above[i];
+		float d5 = h - above[i + 1];
+		float d6 = h - below[i - 1];
+		float d7 = h - below[i];
+		float d8 = h - below[i + 1];
+
+		// Drops this vertex sheds down, and rises its neighbours shed down onto it
+		float lost = s * ((d1 > talus ? d1 : 0.0f) + (d2 > talus ? d2 : 0.0f) + (d3 > talus ? d3 : 0.0f) +
+			(d4 > talus ? d4 : 0.0f) + (d5 > talus ? d5 : 0.0f) + (d6 > talus ? d6 : 0.0f) +
+			(d7 > talus ? d7 : 0.0f) + (d8 > talus ? d8 : 0.0f));
+
+		float gained = (shed[i - 1] * (-d1 > talus ? -d1 : 0.0f)) + (shed[i + 1] * (-d2 > talus ? -d2 : 0.0f)) +
+			(shedAbove[i - 1] * (-d3 > talus ? -d3 : 0.0f)) + (shedAbove[i] * (-d4 > talus ? -d4 : 0.0f)) +
+			(shedAbove[i + 1] * (-d5 > talus ? -d5 : 0.0f)) + (shedBelow[i - 1] * (-d6 > talus ? -d6 : 0.0f)) +
+			(shedBelow[i] * (-d7 > talus ? -d7 : 0.0f)) + (shedBelow[i + 1] * (-d8 > talus ? -d8 : 0.0f));
+
+		result[i] = h - lost + gained;
+
+	}
+
+	// Found in a second loop, as the compiler won't vectorise the one above with a float max in it
+	float mostChanged = 0.0f;
+
+	for (int i = columnBegin; i < columnEnd; i++)
+	{
+
+		mostChanged = std::max(mostChanged, std::fabs(result[i] - centre[i]));
+
+	}
+
+	return mostChanged;
+
+}
+
+template <class Boundary>
+void HeightField::ParallelThermalErosionPass(int erosionIterations)
+{
+
+	float talus = 4.0f / resolution;			// Calculate a reasonable talus angle
+	float c = 0.5f;								// Constant C
+
+	if (swapData == 0)
+	{
+
+		swapData = CreateGrid();
+
+	}
+
+	if (filterData == 0)
+	{
+
+		filterData = CreateGrid();
+
+	}
+
+	// How much each vertex sheds per unit of height difference to every neighbour more than talus below it
+	float* outflow = filterData + stride + 1;
+
+	thermalStats.iterations = 0;
+	thermalStats.cellsProcessed = 0;
+	thermalStats.maxTransfer = 0.0f;
+
+	if (thermalConvergence == true)
+	{
+
+		ParallelThermalErosionTiles<Boundary>(erosionIterations, talus, c, outflow, swapData + stride + 1);
+		return;
+
+	}
+
+	// Largest change to a vertex in each row, so the largest transfer can be found without the threads sharing anything
+	float* rowTransfer = new float[resolution];
+
+	for (int k = 0; k < erosionIterations; k++)
+	{
+
+		// A wall is higher than anything on the map and sheds nothing, so no material crosses it
+		FillGhostCells<Boundary>(heights, FLT_MAX);
+
+		// First pass, every vertex works out what it sheds from the heights at the start of the iteration
+		threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+		{
+
+			for (int j = rowBegin; j < rowEnd; j++)
+			{
+
+				ThermalOutflowRow(j, 0, resolution, talus, c, outflow);
+
+			}
+
+		});
+
+		FillGhostCells<Boundary>(outflow, 0.0f);
+
+		float* destination = swapData + stride + 1;
+
+		// Second pass, every vertex loses what it sheds and gains what its neighbours shed onto it
+		threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+		{
+
+			for (int j = rowBegin; j < rowEnd; j++)
+			{
+
+				rowTransfer[j] = ThermalGatherRow(j, 0, resolution, talus, outflow, destination);
+
+			}
+
+		});
+
+		SwapHeights();
+
+		thermalStats.iterations++;
+		thermalStats.cellsProcessed += (long long)resolution * resolution;
+		thermalStats.maxTransfer = *std::max_element(rowTransfer, rowTransfer + resolution);
+
+	}
+
+	delete[] rowTransfer;
+
+}
+
+template <class Boundary>
+int HeightField::ListTiles(const char* flags, int tiles, char* listed, int* list)
+{
+
+	int count = 0;
+
+	for (int t = 0; t < tiles * tiles; t++)
+	{
+
+		listed[t] = 0;
+
+	}
+
+	for (int ty = 0; ty < tiles; ty++)
+	{
+
+		for (int tx = 0; tx < tiles; tx++)
+		{
+
+			if (flags[(tiles * ty) + tx] == 0)
+			{
+
+				continue;
+
+			}
+
+			// A tile's edge vertices read the neighbouring tiles, across the edge of the map if it wraps
+			for (int ny = ty - 1; ny <= ty + 1; ny++)
+			{
+
+				for (int nx = tx - 1; nx <= tx + 1; nx++)
+				{
+
+					bool onMap = nx >= 0 && nx < tiles && ny >= 0 && ny < tiles;
+
+					if (onMap == false && Boundary::isWall)
+					{
+
+						continue;
+
+					}
+
+					int tile = (tiles * Boundary::Source(ny, tiles)) + Boundary::Source(nx, tiles);
+
+					if (listed[tile] == 0)
+					{
+
+						listed[tile] = 1;
+						list[count++] = tile;
+
+					}
+
+				}
+
+			}
+
+		}
+
+	}
+
+	// Keep the tiles in map order, so the work is handed out the same way whatever order they were flagged in
+	std::sort(list, list + count);
+
+	return count;
+
+}
+
+template <class Boundary>
+void HeightField::ParallelThermalErosionTiles(int erosionIterations, float talus, float c, float* outflow, float* destination)
+{
+
+	int tiles = (resolution + THERMAL_TILE_SIZE - 1) / THERMAL_TILE_SIZE;
+	int tileCount = tiles * tiles;
+
+	char* changed = new char[tileCount];		// Heights changed last iteration, so their outflow and their neighbours' is out of date
+	char* shedding = new char[tileCount];		// Some vertex sheds material, so it and its neighbours will change
+	char* listed = new char[tileCount];
+	int* worklist = new int[tileCount];
+	float* tileTransfer = new float[tileCount];
+
+	// Nothing is known about the terrain yet, so every tile starts out changed
+	for (int t = 0; t < tileCount; t++)
+	{
+
+		changed[t] = 1;
+		shedding[t] = 0;
+
+	}
+
+	for (int k = 0; k < erosionIterations; k++)
+	{
+
+		FillGhostCells<Boundary>(heights, FLT_MAX);
+
+		// Tiles whose outflow could be different to last time, everywhere else it still holds
+		int count = ListTiles<Boundary>(changed, tiles, listed, worklist);
+
+		threadPool->ParallelFor(count, 1, [&](int begin, int end)
+		{
+
+			for (int w = begin; w < end; w++)
+			{
+
+				int tile = worklist[w];
+				int columnBegin = (tile % tiles) * THERMAL_TILE_SIZE;
+				int rowBegin = (tile / tiles) * THERMAL_TILE_SIZE;
+				bool sheds = false;
+
+				for (int j = rowBegin; j < std::min(rowBegin + THERMAL_TILE_SIZE, resolution); j++)
+				{
+
+					sheds = ThermalOutflowRow(j, columnBegin, std::min(columnBegin + THERMAL_TILE_SIZE, resolution), talus, c, outflow) || sheds;
+
+				}
+
+				shedding[tile] = sheds;
+
+			}
+
+		});
+
+		FillGhostCells<Boundary>(outflow, 0.0f);
+
+		// Only tiles that shed and their neighbours can change, once there are none the terrain has settled
+		count = ListTiles<Boundary>(shedding, tiles, listed, worklist);
+
+		if (count == 0)
+		{
+
+			break;
+
+		}
+
+		threadPool->ParallelFor(count, 1, [&](int begin, int end)
+		{
+
+			for (int w = begin; w < end; w++)
+			{
+
+				int tile = worklist[w];
+				int columnBegin = (tile % tiles) * THERMAL_TILE_SIZE;
+				int rowBegin = (tile / tiles) * THERMAL_TILE_SIZE;
+				float mostChanged = 0.0f;
+
+				for (int j = rowBegin; j < std::min(rowBegin + THERMAL_TILE_SIZE, resolution); j++)
+				{
+
+					mostChanged = std::max(mostChanged, ThermalGatherRow(j, columnBegin, std::min(columnBegin + THERMAL_TILE_SIZE, resolution), talus, outflow, destination));
+
+				}
+
+				tileTransfer[tile] = mostChanged;
+
+			}
+
+		});
+
+		// Only some tiles were updated, so copy them back rather than swapping the whole grid, noting which ones changed
+		for (int t = 0; t < tileCount; t++)
+		{
+
+			changed[t] = 0;
+
+		}
+
+		threadPool->ParallelFor(count, 1, [&](int begin, int end)
+		{
+
+			for (int w = begin; w < end; w++)
+			{
+
+				int tile = worklist[w];
+				int columnBegin = (tile % tiles) * THERMAL_TILE_SIZE;
+				int columnEnd = std::min(columnBegin + THERMAL_TILE_SIZE, resolution);
+				int rowBegin = (tile / tiles) * THERMAL_TILE_SIZE;
+				bool different = false;
+
+				for (int j = rowBegin; j < std::min(rowBegin + THERMAL_TILE_SIZE, resolution); j++)
+				{
+
+					float* row = heights + (stride * j);
+					const float* eroded = destination + (stride * j);
+
+					for (int i = columnBegin; i < columnEnd; i++)
+					{
+
+						different = different || row[i] != eroded[i];
+						row[i] = eroded[i];
+
+					}
+
+				}
+
+				changed[tile] = different;
+
+			}
+
+		});
+
+		thermalStats.iterations++;
+		thermalStats.maxTransfer = 0.0f;
+
+		for (int w = 0; w < count; w++)
+		{
+
+			int tile = worklist[w];
+			int columns = std::min(THERMAL_TILE_SIZE, resolution - ((tile % tiles) * THERMAL_TILE_SIZE));
+			int rows = std::min(THERMAL_TILE_SIZE, resolution - ((tile / tiles) * THERMAL_TILE_SIZE));
+
+			thermalStats.cellsProcessed += columns * rows;
+			thermalStats.maxTransfer = std::max(thermalStats.maxTransfer, tileTransfer[tile]);
+
+		}
+
+		if (thermalStats.maxTransfer <= thermalTolerance)
+		{
+
+			break;
+
+		}
+
+	}
+
+	delete[] changed;
+	delete[] shedding;
+	delete[] listed;
+	delete[] worklist;
+	delete[] tileTransfer;
+
+}
+
+void HeightField::PyramidThermalErosion(int erosionIterations, int levels)
+{
+
+	// The heights no longer come straight from the noise, so they can't be scrolled
+	scrollValid = false;
+
+	// Each level halves the one above, stopping before the grid is too small to erode on
+	levels = std::max(levels, 1);
+
+	HeightField** pyramid = new HeightField*[levels];
+	float** original = new float*[levels];
+	int levelCount = 1;
+
+	pyramid[0] = this;
+	original[0] = 0;
+
+	while (levelCount < levels && (pyramid[levelCount - 1]->resolution + 1) / 2 >= PYRAMID_MIN_RESOLUTION)
+	{
+
+		HeightField* fine = pyramid[levelCount - 1];
+		HeightField* coarse = new HeightField(perlinNoiseGen, simplexNoiseGen, (fine->resolution + 1) / 2);
+
+		coarse->SetThreadCount(GetThreadCount());
+		coarse->SetBoundaryMode(boundaryMode);
+		coarse->SetThermalErosionConvergence(thermalConvergence, thermalTolerance);
+		coarse->DownsampleHeights(*fine);
+
+		// Kept so the change erosion makes to the level can be handed on to the next one up
+		original[levelCount] = coarse->CreateGrid();
+		memcpy(original[levelCount], coarse->heightData, coarse->stride * coarse->stride * sizeof(float));
+
+		pyramid[levelCount] = coarse;
+		levelCount++;
+
+	}
+
+	long long cellsProcessed = 0;
+	int iterations = 0;
+
+	for (int level = levelCount - 1; level >= 0; level--)
+	{
+
+		HeightField* field = pyramid[level];
+
+		field->ParallelThermalErosion(erosionIterations);
+
+		iterations += field->thermalStats.iterations;
+		cellsProcessed += field->thermalStats.cellsProcessed;
+
+		if (level > 0)
+		{
+
+			// Everything this level and the ones below it did, moved up onto the next finer level
+			float* change = original[level] + field->stride + 1;
+
+			for (int j = 0; j < field->resolution; j++)
+			{
+
+				for (int i = 0; i < field->resolution; i++)
+				{
+
+					change[(field->stride * j) + i] = field->heights[(field->stride * j) + i] - change[(field->stride * j) + i];
+
+				}
+
+			}
+
+			pyramid[level - 1]->AddUpsampled(change, field->resolution, field->stride);
+
+			delete[] original[level];
+			delete field;
+
+		}
+
+	}
+
+	// The full resolution pass has already set maxTransfer
+	thermalStats.iterations = iterations;
+	thermalStats.cellsProcessed = cellsProcessed;
+
+	delete[] pyramid;
+	delete[] original;
+
+}
+
+void HeightField::DownsampleHeights(const HeightField& fine)
+{
+
+	threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+	{
+
+		for (int j = rowBegin; j < rowEnd; j++)
+		{
+
+			// An odd fine grid has no vertex past its last one, so the last block is just that vertex
+			const float* upper = fine.heights + (fine.stride * (2 * j));
+			const float* lower = fine.heights + (fine.stride * std::min((2 * j) + 1, fine.resolution - 1));
+			float* result = heights + (stride * j);
+
+			for (int i = 0; i < resolution; i++)
+			{
+
+				int left = 2 * i;
+				int right = std::min((2 * i) + 1, fine.resolution - 1);
+
+				result[i] = 0.25f * (upper[left] + upper[right] + lower[left] + lower[right]);
+
+			}
+
+		}
+
+	});
+
+}
+
+void HeightField::AddUpsampled(const float* coarse, int coarseResolution, int coarseStride)
+{
+
+	// A coarse vertex averages two fine ones, so it sits half way between them
+	int* column = new int[resolution];
+	float* columnWeight = new float[resolution];
+
+	for (int i = 0; i < resolution; i++)
+	{
+
+		float x = std::min(std::max((0.5f * i) - 0.25f, 0.0f), (float)(coarseResolution - 1));
+
+		column[i] = std::min((int)x, coarseResolution - 2);
+		columnWeight[i] = x - column[i];
+
+	}
+
+	threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+	{
+
+		for (int j = rowBegin; j < rowEnd; j++)
+		{
+
+			float z = std::min(std::max((0.5f * j) - 0.25f, 0.0f), (float)(coarseResolution - 1));
+			int row = std::min((int)z, coarseResolution - 2);
+			float rowWeight = z - row;
+
+			const float* upper = coarse + (coarseStride * row);
+			const float* lower = upper + coarseStride;
+			float* result = heights + (stride * j);
+
+			for (int i = 0; i < resolution; i++)
+			{
+
+				float top = upper[column[i]] + ((upper[column[i] + 1] - upper[column[i]]) * columnWeight[i]);
+				float bottom = lower[column[i]] + ((lower[column[i] + 1] - lower[column[i]]) * columnWeight[i]);
+
+				result[i] += top + ((bottom - top) * rowWeight);
+
+			}
+
+		}
+
+	});
+
+	delete[] column;
+	delete[] columnWeight;
+
+}
+
+void HeightField::HydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence)
+{
+
+	// The heights no longer come straight from the noise, so they can't be scrolled
+	scrollValid = false;
+
+	switch (boundaryMode)
+	{
+
+	case BOUNDARY_CLAMP:
+		HydraulicErosionPass<ClampBoundary>(carryingCapacity, depositionSpeed, iterations, drops, persistence);
+		break;
+
+	case BOUNDARY_MIRROR:
+		HydraulicErosionPass<MirrorBoundary>(carryingCapacity, depositionSpeed, iterations, drops, persistence);
+		break;
+
+	case BOUNDARY_WRAP:
+		HydraulicErosionPass<WrapBoundary>(carryingCapacity, depositionSpeed, iterations, drops, persistence);
+		break;
+
+	default:
+		HydraulicErosionPass<WallBoundary>(carryingCapacity, depositionSpeed, iterations, drops, persistence);
+		break;
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::HydraulicErosionPass(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence)
+{
+
+	FillGhostCells<Boundary>(heights, HYDRAULIC_WALL_HEIGHT);
+
+	ResetHydraulicStats(hydraulicStats);
+
+	// Droplets are only dropped on land, so none are wasted on the water
+	int* land = new int[resolution * resolution];
+	int landCount = ListLandCells(land);
+
+	// Place droplets across the terrain until the specified number is reached
+	// Generally numbers in the low millions work well for this, see GetHydraulicErosionStats for how much they did
+	for (int drop = 0; drop < drops && landCount > 0; drop++)
+	{
+
+		// Get a random land vertex to drop the water droplet at, from two draws as RAND_MAX can be as small as 32767
+		long long draw = ((long long)rand() * ((long long)RAND_MAX + 1)) + rand();
+		int cell = land[draw % landCount];
+
+		RunDroplet<Boundary>(cell % resolution, cell / resolution, carryingCapacity, depositionSpeed, iterations, persistence, hydraulicStats);
+
+	}
+
+	FinishHydraulicStats(hydraulicStats);
+
+	delete[] land;
+
+}
+
+void HeightField::ParallelHydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence,
+	unsigned int seed)
+{
+
+	// The heights no longer come straight from the noise, so they can't be scrolled
+	scrollValid = false;
+
+	switch (boundaryMode)
+	{
+
+	case BOUNDARY_CLAMP:
+		ParallelHydraulicErosionPass<ClampBoundary>(carryingCapacity, depositionSpeed, iterations, drops, persistence, seed);
+		break;
+
+	case BOUNDARY_MIRROR:
+		ParallelHydraulicErosionPass<MirrorBoundary>(carryingCapacity, depositionSpeed, iterations, drops, persistence, seed);
+		break;
+
+	case BOUNDARY_WRAP:
+		ParallelHydraulicErosionPass<WrapBoundary>(carryingCapacity, depositionSpeed, iterations, drops, persistence, seed);
+		break;
+
+	default:
+		ParallelHydraulicErosionPass<WallBoundary>(carryingCapacity, depositionSpeed, iterations, drops, persistence, seed);
+		break;
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::ParallelHydraulicErosionPass(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence,
+	unsigned int seed)
+{
+
+	FillGhostCells<Boundary>(heights, HYDRAULIC_WALL_HEIGHT);
+
+	// A droplet moves at most one vertex a step and reads one vertex further, so droplets starting in tiles this far apart
+	// can never touch the same vertex
+	int tileSize = std::max(2 * (iterations + 1), 1);
+	int tilesAcross = std::max(resolution / tileSize, 1);
+
+	// Tiles are coloured in a 2x2 checkerboard, which only works across a wrapping edge with an even number of tiles
+	if (Boundary::wraps && tilesAcross % 2 == 1 && tilesAcross > 1)
+	{
+
+		tilesAcross--;
+
+	}
+
+	int tileCount = tilesAcross * tilesAcross;
+
+	ResetHydraulicStats(hydraulicStats);
+
+	int* land = new int[resolution * resolution];
+	int landCount = ListLandCells(land);
+
+	if (landCount == 0)
+	{
+
+		delete[] land;
+		return;
+
+	}
+
+	// Tile each row and column of vertices falls in
+	int* tileOf = new int[resolution];
+
+	for (int t = 0; t < tilesAcross; t++)
+	{
+
+		for (int k = (t * resolution) / tilesAcross; k < ((t + 1) * resolution) / tilesAcross; k++)
+		{
+
+			tileOf[k] = t;
+
+		}
+
+	}
+
+	// Droplet n starts at the land vertex drawn from the n-th random number, so where droplets start doesn't depend on the threads
+	int* startX = new int[drops];
+	int* startY = new int[drops];
+	int* tileDrops = new int[tileCount + 1];
+	int* order = new int[drops];
+
+	for (int t = 0; t <= tileCount; t++)
+	{
+
+		tileDrops[t] = 0;
+
+	}
+
+	for (int drop = 0; drop < drops; drop++)
+	{
+
+		int cell = land[CounterRandomRange((uint32_t)CounterRandom(seed, drop), landCount)];
+
+		startX[drop] = cell % resolution;
+		startY[drop] = cell / resolution;
+
+		tileDrops[(tilesAcross * tileOf[startY[drop]]) + tileOf[startX[drop]] + 1]++;
+
+	}
+
+	// Sort the droplets by tile, keeping them in order within each tile
+	for (int t = 0; t < tileCount; t++)
+	{
+
+		tileDrops[t + 1] += tileDrops[t];
+
+	}
+
+	int* next = new int[tileCount];
+	memcpy(next, tileDrops, tileCount * sizeof(int));
+
+	for (int drop = 0; drop < drops; drop++)
+	{
+
+		order[next[(tilesAcross * tileOf[startY[drop]]) + tileOf[startX[drop]]]++] = drop;
+
+	}
+
+	// Tiles of one colour are a tile apart, so each colour's tiles can run at the same time, and the colours run in turn
+	// Each tile counts what its droplets did separately, and the counts are added up in tile order so they don't depend on the threads
+	int* colourTiles = new int[tileCount];
+	HydraulicErosionStats* tileStats = new HydraulicErosionStats[tileCount];
+
+	for (int t = 0; t < tileCount; t++)
+	{
+
+		ResetHydraulicStats(tileStats[t]);
+
+	}
+
+	for (int colour = 0; colour < 4; colour++)
+	{
+
+		int count = 0;
+
+		for (int t = 0; t < tileCount; t++)
+		{
+
+			if ((((t / tilesAcross) % 2) * 2) + ((t % tilesAcross) % 2) == colour)
+			{
+
+				colourTiles[count++] = t;
+
+			}
+
+		}
+
+		threadPool->ParallelFor(count, 1, [&](int begin, int end)
+		{
+
+			for (int c = begin; c < end; c++)
+			{
+
+				int tile = colourTiles[c];
+
+				for (int k = tileDrops[tile]; k < tileDrops[tile + 1]; k++)
+				{
+
+					RunDroplet<Boundary>(startX[order[k]], startY[order[k]], carryingCapacity, depositionSpeed, iterations, persistence,
+						tileStats[tile]);
+
+				}
+
+			}
+
+		});
+
+	}
+
+	for (int t = 0; t < tileCount; t++)
+	{
+
+		hydraulicStats.droplets += tileStats[t].droplets;
+		hydraulicStats.steps += tileStats[t].steps;
+		hydraulicStats.stalledDroplets += tileStats[t].stalledDroplets;
+		hydraulicStats.exitedDroplets += tileStats[t].exitedDroplets;
+		hydraulicStats.sedimentEroded += tileStats[t].sedimentEroded;
+		hydraulicStats.sedimentDeposited += tileStats[t].sedimentDeposited;
+
+	}
+
+	FinishHydraulicStats(hydraulicStats);
+
+	delete[] land;
+	delete[] tileOf;
+	delete[] startX;
+	delete[] startY;
+	delete[] tileDrops;
+	delete[] order;
+	delete[] next;
+	delete[] colourTiles;
+	delete[] tileStats;
+
+}
+
+const HeightField::HydraulicErosionStats& HeightField::GetHydraulicErosionStats() const
+{
+
+	return hydraulicStats;
+
+}
+
+int HeightField::ListLandCells(int* cells) const
+{
+
+	int count = 0;
+
+	for (int j = 0; j < resolution; j++)
+	{
+
+		const float* row = heights + (stride * j);
+
+		for (int i = 0; i < resolution; i++)
+		{
+
+			if (row[i] > 0.0f)
+			{
+
+				cells[count++] = (resolution * j) + i;
+
+			}
+
+		}
+
+	}
+
+	return count;
+
+}
+
+void HeightField::ResetHydraulicStats(HydraulicErosionStats& stats)
+{
+
+	stats.droplets = 0;
+	stats.steps = 0;
+	stats.stalledDroplets = 0;
+	stats.exitedDroplets = 0;
+	stats.sedimentEroded = 0.0;
+	stats.sedimentDeposited = 0.0;
+	stats.averagePathLength = 0.0;
+
+}
+
+void HeightField::FinishHydraulicStats(HydraulicErosionStats& stats)
+{
+
+	stats.averagePathLength = stats.droplets > 0 ? (double)stats.steps / stats.droplets : 0.0;
+
+}
+
+template <class Boundary>
+void HeightField::RunDroplet(int X, int Y, float carryingCapacity, float depositionSpeed, int iterations, float persistence,
+	HydraulicErosionStats& stats)
+{
+
+	// Initialise working values
+	float carryingAmount = 0.0f;	// Amount of sediment that is currently being carried
+	float minSlope = 1.15f;			// Minimum value for the slope/height difference
+	float p = 1.0f;					// Persistence
+
+	// Limit calculations to only be run on terrain that is above water
+	// Droplets start on land, but an earlier droplet may have worn their vertex down below it since
+	if (heights[(stride * Y) + X] <= 0.0f)
+	{
+
+		return;
+
+	}
+
+	// Counted locally and added to stats at the end, so the loop doesn't keep writing them back
+	int steps = 0;
+	int stalled = 0;
+	int exited = 0;
+	float eroded = 0.0f;
+	float deposited = 0.0f;
+
+	// Iterate based on user's input
+	for (int iter = 0; iter < iterations; iter++)
+	{
+
+		// Get the location of the cell and its von Neumann neighbourhood, the ghost border covers the edges
+		int index = (stride * Y) + X;
+		float val = heights[index];
+		float left = heights[index - 1];
+		float right = heights[index + 1];
+		float up = heights[index + stride];
+		float down = heights[index - stride];
+
+		// Find the minimum height value among the cell's neighbourhood, and its direction
+		float minHeight = val;
+		int moveX = 0;
+		int moveY = 0;
+
+		if (left < minHeight)
+		{
+
+			minHeight = left;
+			moveX = -1;
+
+		}
+
+		if (right < minHeight)
+		{
+
+			minHeight = right;
+			moveX = 1;
+
+		}
+
+		if (up < minHeight)
+		{
+
+			minHeight = up;
+			moveX = 0;
+			moveY = 1;
+
+		}
+
+		if (down < minHeight)
+		{
+
+			minHeight = down;
+			moveX = 0;
+			moveY = -1;
+
+		}
+
+		// If the lowest neighbor is NOT lower than the current value the droplet is in a pit
+		// Nothing changes under it there, so it would sit still for the rest of its iterations
+		if (minHeight >= val)
+		{
+
+			stalled = 1;
+			break;
+
+		}
+
+		// Deposit or erode
+		float slope = std::min(minSlope, (val - minHeight));
+		float valueToSteal = depositionSpeed * slope;
+
+		// If carrying amount is greater than carryingCapacity
+		if (carryingAmount > carryingCapacity)
+		{
+
+			// Deposit sediment
+			carryingAmount -= valueToSteal;
+			heights[index] += valueToSteal * persistence;
+			deposited += valueToSteal * persistence;
+
+		}
+		else {
+
+			// Else erode the cell
+			// Check that we're within carrying capacity
+			if (carryingAmount + valueToSteal > carryingCapacity)
+			{
+
+				// If not, calculate the amount that's above the carrying capacity and erode by delta
+				float delta = carryingAmount + valueToSteal - carryingCapacity;
+				carryingAmount += delta;
+				heights[index] -= delta * persistence;
+				eroded += delta * persistence;
+
+			}
+			else
+			{
+
+				// Else erode by valueToSteal
+				carryingAmount += valueToSteal;
+				heights[index] -= valueToSteal * persistence;
+				eroded += valueToSteal * persistence;
+
+			}
+
+		}
+
+		RefreshGhostCells<Boundary>(X, Y);
+		steps++;
+
+		// A droplet running down over a wall has left the map
+		if (Boundary::isWall && (X + moveX < 0 || X + moveX >= resolution || Y + moveY < 0 || Y + moveY >= resolution))
+		{
+
+			exited = 1;
+			break;
+
+		}
+
+		// Move to next value, a step onto a ghost cell lands on the vertex it copies
+		X = Boundary::Source(X + moveX, resolution);
+		Y = Boundary::Source(Y + moveY, resolution);
+
+		// Decrease persistence for next iteration
+		p *= persistence;
+
+	}
+
+	stats.droplets++;
+	stats.steps += steps;
+	stats.stalledDroplets += stalled;
+	stats.exitedDroplets += exited;
+	stats.sedimentEroded += eroded;
+	stats.sedimentDeposited += deposited;
+
+}
+
+void HeightField::PipeHydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, float rainfall, float evaporation)
+{
+
+	// The heights no longer come straight from the noise, so they can't be scrolled
+	scrollValid = false;
+
+	// Sediment is carried between vertices, so there has to be more than one
+	if (resolution < 2)
+	{
+
+		return;
+
+	}
+
+	if (boundaryMode == BOUNDARY_WRAP)
+	{
+
+		PipeHydraulicErosionPass<WrapBoundary>(carryingCapacity, depositionSpeed, iterations, rainfall, evaporation);
+
+	}
+	else
+	{
+
+		PipeHydraulicErosionPass<WallBoundary>(carryingCapacity, depositionSpeed, iterations, rainfall, evaporation);
+
+	}
+
+}
+
+template <class Boundary>
+void HeightField::PipeHydraulicErosionPass(float carryingCapacity, float depositionSpeed, int iterations, float rainfall, float evaporation)
+{
+
+	if (swapData == 0)
+	{
+
+		swapData = CreateGrid();
+
+	}
+
+	// Every field is laid out like the heights, so the same ghost cells give each vertex its neighbours
+	float* waterData = CreateGrid();			// Depth of water over each vertex
+	float* fluxLeftData = CreateGrid();			// Water flowing through the pipe to each neighbour per unit of time
+	float* fluxRightData = CreateGrid();
+	float* fluxUpData = CreateGrid();
+	float* fluxDownData = CreateGrid();
+	float* speedData = CreateGrid();			// Speed the water moves at, in vertices per unit of time
+	float* sedimentData = CreateGrid();			// Height of material suspended in the water
+	float* carriedData = CreateGrid();			// Sediment per unit depth of water, what each unit of water takes with it
+
+	float* water = waterData + stride + 1;
+	float* fluxLeft = fluxLeftData + stride + 1;
+	float* fluxRight = fluxRightData + stride + 1;
+	float* fluxUp = fluxUpData + stride + 1;
+	float* fluxDown = fluxDownData + stride + 1;
+	float* speed = speedData + stride + 1;
+	float* sediment = sedimentData + stride + 1;
+	float* carried = carriedData + stride + 1;
+
+	float dt = PIPE_TIME_STEP;
+	float spacing = PositionX(1) - PositionX(0);
+	float retained = std::max(1.0f - (evaporation * dt), 0.0f);
+
+	for (int k = 0; k < iterations; k++)
+	{
+
+		// Nothing flows into a wall, so its surface is higher than anything on the map
+		FillGhostCells<Boundary>(heights, FLT_MAX);
+		FillGhostCells<Boundary>(water, 0.0f);
+
+		// Rain falls evenly so it doesn't change the difference in surface height to any neighbour, only how much can flow
+		threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+		{
+
+			for (int j = rowBegin; j < rowEnd; j++)
+			{
+
+				int row = stride * j;
+
+				for (int i = row; i < row + resolution; i++)
+				{
+
+					float depth = water[i] + rainfall;
+					float surface = heights[i] + water[i];
+
+					// Each pipe speeds up with the drop in surface height along it, and never flows backwards
+					float left = std::max(fluxLeft[i] + (dt * PIPE_GRAVITY * (surface - heights[i - 1] - water[i - 1])), 0.0f);
+					float right = std::max(fluxRight[i] + (dt * PIPE_GRAVITY * (surface - heights[i + 1] - water[i + 1])), 0.0f);
+					float up = std::max(fluxUp[i] + (dt * PIPE_GRAVITY * (surface - heights[i + stride] - water[i + stride])), 0.0f);
+					float down = std::max(fluxDown[i] + (dt * PIPE_GRAVITY * (surface - heights[i - stride] - water[i - stride])), 0.0f);
+
+					// Scale the outflow down so no more water leaves the vertex than it holds
+					float outflow = (left + right + up + down) * dt;
+					float scale = depth / std::max(std::max(outflow, depth), FLT_MIN);
+
+					fluxLeft[i] = left * scale;
+					fluxRight[i] = right * scale;
+					fluxUp[i] = up * scale;
+					fluxDown[i] = down * scale;
+
+				}
+
+			}
+
+		});
+
+		// Walls neither take nor give any water
+		FillGhostCells<Boundary>(fluxLeft, 0.0f);
+		FillGhostCells<Boundary>(fluxRight, 0.0f);
+		FillGhostCells<Boundary>(fluxUp, 0.0f);
+		FillGhostCells<Boundary>(fluxDown, 0.0f);
+
+		// Move the water, and work out how fast it's going from the flow through the vertex and its average depth
+		threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+		{
+
+			for (int j = rowBegin; j < rowEnd; j++)
+			{
+
+				int row = stride * j;
+
+				for (int i = row; i < row + resolution; i++)
+				{
+
+					float inflow = fluxRight[i - 1] + fluxLeft[i + 1] + fluxUp[i - stride] + fluxDown[i + stride];
+					float outflow = fluxLeft[i] + fluxRight[i] + fluxUp[i] + fluxDown[i];
+
+					float depth = water[i] + rainfall;
+					float newDepth = std::max(depth + (dt * (inflow - outflow)), 0.0f);
+					float averageDepth = std::max(0.5f * (depth + newDepth), PIPE_MIN_DEPTH);
+
+					float velocityX = 0.5f * (fluxRight[i - 1] - fluxLeft[i] + fluxRight[i] - fluxLeft[i + 1]) / averageDepth;
+					float velocityZ = 0.5f * (fluxUp[i - stride] - fluxDown[i] + fluxUp[i] - fluxDown[i + stride]) / averageDepth;
+
+					speed[i] = std::sqrt((velocityX * velocityX) + (velocityZ * velocityZ));
+					carried[i] = sediment[i] / std::max(depth, FLT_MIN);
+					water[i] = newDepth;
+
+				}
+
+			}
+
+		});
+
+		FillGhostCells<Boundary>(carried, 0.0f);
+
+		// The slope under the water sets how much it can carry, and there is no slope up a wall
+		if (Boundary::isWall)
+		{
+
+			FillGhostCells<ClampBoundary>(heights, 0.0f);
+
+		}
+		else
+		{
+
+			FillGhostCells<Boundary>(heights, 0.0f);
+
+		}
+
+		float* destination = swapData + stride + 1;
+
+		// The sediment moves along the pipes with the water, so none is lost or made on the way
+		// Then water carrying less than it can picks material up off the terrain, and water carrying more puts it down
+		threadPool->ParallelFor(resolution, RowsPerBlock(resolution), [&](int rowBegin, int rowEnd)
+		{
+
+			for (int j = rowBegin; j < rowEnd; j++)
+			{
+
+				int row = stride * j;
+
+				for (int i = row; i < row + resolution; i++)
+				{
+
+					float outflow = fluxLeft[i] + fluxRight[i] + fluxUp[i] + fluxDown[i];
+					float arriving = (fluxRight[i - 1] * carried[i - 1]) + (fluxLeft[i + 1] * carried[i + 1]) +
+						(fluxUp[i - stride] * carried[i - stride]) + (fluxDown[i + stride] * carried[i + stride]);
+
+					float suspended = std::max(sediment[i] + (dt * (arriving - (outflow * carried[i]))), 0.0f);
+
+					// Steepest drop to a neighbour, rather than a central difference which can't see a vertex sticking up or
+					// sinking below both its neighbours, and would let the terrain break up into a checkerboard
+					float h = heights[i];
+					float drop = std::max(std::max(std::max(h - heights[i - 1], h - heights[i + 1]),
+						std::max(h - heights[i + stride], h - heights[i - stride])), 0.0f);
+					float slope = drop / spacing;
+					float sine = slope / std::sqrt(1.0f + (slope * slope));
+
+					// How much the water can carry grows with how much of it flows past, speed times depth, so a film of
+					// water running quickly over dry ground doesn't strip the terrain
+					float capacity = carryingCapacity * sine * speed[i] * water[i];
+
+					// Never dig a vertex below its lowest neighbour in one step, or put down more sediment than the water carries
+					float change = std::max(std::min(depositionSpeed * (capacity - suspended), drop), -suspended);
+
+					destination[i] = heights[i] - change;
+					sediment[i] = suspended + change;
+					water[i] *= retained;
+
+				}
+
+			}
+
+		});
+
+		SwapHeights();
+
+	}
+
+	// Whatever the water still carries settles where it is as the water drains away
+	for (int j = 0; j < resolution; j++)
+	{
+
+		for (int i = 0; i < resolution; i++)
+		{
+
+			heights[(stride * j) + i] += sediment[(stride * j) + i];
+
+		}
+
+	}
+
+	delete[] waterData;
+	delete[] fluxLeftData;
+	delete[] fluxRightData;
+	delete[] fluxUpData;
+	delete[] fluxDownData;
+	delete[] speedData;
+	delete[] sedimentData;
+	delete[] carriedData;
+
+}
+
+bool HeightField::CalculateNormals()
+{
+
+	return CalculateNormals(0, resolution, 0, resolution);
+
+}
+
+bool HeightField::CalculateNormals(int rowBegin, int rowEnd, int columnBegin, int columnEnd)
+{
+
+	// Normals are only kept for heightfields that need them, so the array is created the first time they're calculated
+	if (normals == 0)
+	{
+
+		normals = new VectorType[resolution * resolution];
+
+		rowBegin = 0;
+		rowEnd = resolution;
+		columnBegin = 0;
+		columnEnd = resolution;
+
+	}
+
+	// A normal depends on the heights all around its vertex, so the normals one vertex outside the edited heights change too
+	rowBegin = std::max(rowBegin - 1, 0);
+	rowEnd = std::min(rowEnd + 1, resolution);
+	columnBegin = std::max(columnBegin - 1, 0);
+	columnEnd = std::min(columnEnd + 1, resolution);
+
+	if ((rowBegin >= rowEnd) || (columnBegin >= columnEnd))
+	{
+
+		return true;
+
+	}
+
+	int rows = rowEnd - rowBegin;
+
+	threadPool->ParallelFor(rows, RowsPerBlock(rows), [&](int begin, int end)
+	{
+
+		for (int j = rowBegin + begin; j < rowBegin + end; j++)
+		{
+
+			NormalsRow(j, columnBegin, columnEnd);
+
+		}
+
+	});
+
+	return true;
+
+}
+
+void HeightField::NormalsRow(int j, int columnBegin, int columnEnd)
+{
+
+	// The top and bottom rows are missing the faces on one side
+	if ((j == 0) || (j == resolution - 1))
+	{
+
+		for (int i = columnBegin; i < columnEnd; i++)
+		{
+
+			EdgeNormal(i, j);
+
+		}
+
+		return;
+
+	}
+
+	int begin = std::max(columnBegin, 1);
+	int end = std::min(columnEnd, resolution - 1);
+
+	if (columnBegin == 0)
+	{
+
+		EdgeNormal(0, j);
+
+	}
+
+	// Each quad's face is its lower triangle, with the normal (spacing * (h00 - h10), spacing^2, spacing * (h00 - h01))
+	// Summed over the four faces around a vertex the heights in between cancel, leaving differences across the two rows
+	// and the two columns the faces cover. Dividing through by 4 * spacing^2 makes y one, which doesn't change the direction
+	float scale = 0.25f / (PositionX(1) - PositionX(0));
+
+	const float* below = heights + (stride * (j - 1));
+	const float* row = heights + (stride * j);
+	const float* above = heights + (stride * (j + 1));
+	VectorType* normalRow = normals + (resolution * j);
+
+	// Work out the gradients a block at a time, so the square roots run over whole vectors, then interleave them
+	for (int blockBegin = begin; blockBegin < end; blockBegin += NORMAL_BLOCK_SIZE)
+	{
+
+		int count = std::min(end - blockBegin, NORMAL_BLOCK_SIZE);
+		float x[NORMAL_BLOCK_SIZE], z[NORMAL_BLOCK_SIZE], inverse[NORMAL_BLOCK_SIZE];
+
+		for (int k = 0, i = blockBegin; k < count; k++, i++)
+		{
+
+			x[k] = scale * (below[i - 1] - below[i + 1] + row[i - 1] - row[i + 1]);
+			z[k] = scale * (below[i - 1] + below[i] - above[i - 1] - above[i]);
+			inverse[k] = 1.0f / std::sqrt((x[k] * x[k]) + 1.0f + (z[k] * z[k]));
+
+		}
+
+		for (int k = 0, i = blockBegin; k < count; k++, i++)
+		{
+
+			normalRow[i].x = x[k] * inverse[k];
+			normalRow[i].y = inverse[k];
+			normalRow[i].z = z[k] * inverse[k];
+
+		}
+
+	}
+
+	if (columnEnd == resolution)
+	{
+
+		EdgeNormal(resolution - 1, j);
+
+	}
+
+}
+
+void HeightField::EdgeNormal(int i, int j)
+{
+
+	float spacing = PositionX(1) - PositionX(0);
+	float sum[3] = { 0.0f, 0.0f, 0.0f };
+
+	// The faces to the bottom left, bottom right, upper left and upper right of the vertex, where they exist
+	for (int b = j - 1; b <= j; b++)
+	{
+
+		for (int a = i - 1; a <= i; a++)
+		{
+
+			if ((a >= 0) && (b >= 0) && (a < resolution - 1) && (b < resolution - 1))
+			{
+
+				float h = heights[(stride * b) + a];
+
+				sum[0] += spacing * (h - heights[(stride * b) + a + 1]);
+				sum[1] += spacing * spacing;
+				sum[2] += spacing * (h - heights[(stride * (b + 1)) + a]);
+
+			}
+
+		}
+
+	}
+
+	float length = std::sqrt((sum[0] * sum[0]) + (sum[1] * sum[1]) + (sum[2] * sum[2]));
+	int index = (resolution * j) + i;
+
+	// A single vertex has no faces at all, so it points straight up
+	if (length == 0.0f)
+	{
+
+		normals[index].x = 0.0f;
+		normals[index].y = 1.0f;
+		normals[index].z = 0.0f;
+		return;
+
+	}
+
+	normals[index].x = sum[0] / length;
+	normals[index].y = sum[1] / length;
+	normals[index].z = sum[2] / length;
+
+}
@@ -0,0 +1,360 @@
+// HeightField.h
+// Square grid of heights that the terrain is generated and eroded on.
+// Holds everything TerrainMesh does to the terrain except building the DirectX buffers, so it can be used without a device
+// (e.g. by the benchmark in Tools/TerrainBench and the batch generator in Tools/TerrainBake).
+
+#ifndef _HEIGHTFIELD_H_
+#define _HEIGHTFIELD_H_
+
+#include "ImprovedNoise.h"
+#include "SimplexNoise.h"
+#include "FractalNoise.h"
+#include "ThreadPool.h"
+#include "GridBoundary.h"
+
+// How far off a whole number of cells an offset change can be and still count as a scroll
+#define SCROLL_CELL_TOLERANCE 1e-3f
+
+// Height of the wall hydraulic erosion droplets see around the map with BOUNDARY_WALL
+#define HYDRAULIC_WALL_HEIGHT 10.0f
+
+// Side of the square tiles ParallelThermalErosion tracks settled parts of the map in
+#define THERMAL_TILE_SIZE 32
+
+// Time step, gravity and the shallowest water velocities are worked out over for PipeHydraulicErosion
+#define PIPE_TIME_STEP 0.05f
+#define PIPE_GRAVITY 9.81f
+#define PIPE_MIN_DEPTH 0.01f
+
+// Smallest level PyramidThermalErosion halves the heights down to
+#define PYRAMID_MIN_RESOLUTION 16
+
+// Vertices CalculateNormals works out the gradients of at a time, before interleaving them into the normals
+#define NORMAL_BLOCK_SIZE 64
+
+// Filters for SeparableSmoothing
+enum SmoothingFilter
+{
+
+	SMOOTHING_BOX,			// Average of the square window radius vertices either side
+	SMOOTHING_GAUSSIAN		// Three box filters in a row, close to a Gaussian with a standard deviation of sqrt(radius * (radius + 1))
+
+};
+
+class HeightField
+{
+
+public:
+
+	struct VectorType
+	{
+
+		float x, y, z;
+
+	};
+
+	// What the last ParallelThermalErosion call did
+	struct ThermalErosionStats
+	{
+
+		int iterations;				// Iterations run, fewer than asked for if the terrain settled first
+		long long cellsProcessed;	// Vertices updated, added up over every iteration
+		float maxTransfer;			// Largest change to any vertex's height in the last iteration
+
+	};
+
+	// What the droplets of the last HydraulicErosion or ParallelHydraulicErosion call did
+	struct HydraulicErosionStats
+	{
+
+		int droplets;				// Droplets run, those that landed on a vertex worn down below water by earlier ones are skipped
+		long long steps;			// Steps taken down the terrain, added up over every droplet
+		int stalledDroplets;		// Droplets that stopped early in a pit
+		int exitedDroplets;			// Droplets that ran off the edge of the map, only with BOUNDARY_WALL
+		double sedimentEroded;		// Height taken off the terrain
+		double sedimentDeposited;	// Height put back
+		double averagePathLength;	// Steps per droplet
+
+	};
+
+private:
+
+	// Rectangle of vertices, rows [rowBegin, rowEnd) by columns [columnBegin, columnEnd)
+	struct HeightMapRegion
+	{
+
+		int rowBegin, rowEnd;
+		int columnBegin, columnEnd;
+
+	};
+
+	// Everything the unweighted octave layers depend on
+	struct LayerCacheKey
+	{
+
+		float offsetX, offsetZ, frequency;
+		bool simplex, ridged;
+		int resolution;
+
+	};
+
+public:
+
+	HeightField(ImprovedNoise* perlinNoise, SimplexNoise* simplexNoise, int resolution = 100);
+	~HeightField();
+
+	int GetResolution() const;
+
+	// Position of column i and row j, the grid spans 100 units whatever the resolution
+	float PositionX(int i) const;
+	float PositionZ(int j) const;
+
+	// Row-major array of heights, row j runs along x at PositionZ(j) and starts GetStride() * j floats in
+	// Each row is padded with the ghost cells of the boundary, so the stride is wider than the resolution
+	// Double buffered passes swap the array for another one, so get the pointer again after changing the terrain
+	float* GetHeights();
+	const float* GetHeights() const;
+	int GetStride() const;
+
+	// Row-major resolution * resolution array of vertex normals, null until CalculateNormals has been called
+	const VectorType* GetNormals() const;
+
+	// Sets how many threads are used to build the terrain, 0 uses every hardware thread
+	// The generated terrain is identical whatever the thread count
+	void SetThreadCount(int threadCount);
+	int GetThreadCount() const;
+
+	// Keeps the unweighted noise for each octave between calls, so when only the amplitude, persistence, octave count or offsetY
+	// change the heightmap is rebuilt with a weighted sum of the cached layers instead of sampling the noise again.
+	// Gives the same heights as the uncached path. Costs octaves * resolution * resolution floats, and is skipped for
+	// negative amplitudes or persistences
+	void SetLayerCacheEnabled(bool enabled);
+
+	// When only offsetX and offsetZ change, by a whole number of cells, slides the existing heights across
+	// and only samples the rows and columns that scroll into view
+	// Scrolled heights match a full rebuild up to float rounding of the sample positions
+	void SetScrollEnabled(bool enabled);
+
+	// Sets how smoothing and erosion treat the edges of the map, BOUNDARY_WALL by default
+	void SetBoundaryMode(BoundaryMode mode);
+	BoundaryMode GetBoundaryMode() const;
+
+	// Makes SmoothingFunction read every neighbour from before the pass, rather than using neighbours it has already
+	// smoothed, and spreads the rows over the thread pool. The result no longer depends on the order vertices are visited
+	void SetSmoothingDoubleBuffered(bool enabled);
+
+	// Function for generating the heightmap using fractional Brownian motion alongside Perlin noise or Simplex noise
+	void GenerateHeightMap(float offsetX, float offsetZ, float frequency, float amplitude, bool ridged, bool simplex, 
+		int octaves, float persistence, float offsetY);
+
+	// Function for smoothing out generated terrain within given height bounds
+	void SmoothingFunction(float smoothingWeight, float upperBound, float lowerBound);
+
+	// Blurs the terrain with a filter of the given radius, applied as a horizontal then a vertical pass of running sums,
+	// so each pass costs the same whatever the radius. Vertices within the height bounds are blended towards the blurred
+	// terrain by smoothingWeight, like SmoothingFunction. The radius is limited to resolution - 1
+	void SeparableSmoothing(SmoothingFilter filter, int radius, int passes, float smoothingWeight, float upperBound, float lowerBound);
+
+	// Thermal erosion simulates material breaking loose and sliding down slopes over time
+	// Results in generally smoother, flatter terrain
+	// Reference implementation: http://web.mit.edu/cesium/Public/terrain.pdf
+	void ThermalErosion(int erosionIterations);
+
+	// Mass-conserving thermal erosion that runs on every thread. Each iteration first works out how much material every
+	// vertex sheds, from the heights at the start of the iteration, then each vertex gathers what its neighbours shed onto it
+	// Whatever a vertex loses lands on its neighbours, and the result doesn't depend on the thread count
+	// Only wall and wrap boundaries are closed under this, so clamp and mirror boundaries are treated as walls
+	void ParallelThermalErosion(int erosionIterations);
+
+	// Makes ParallelThermalErosion keep a worklist of the tiles that are still changing and only update those and their
+	// neighbours, and stop early once no height changes by more than tolerance in an iteration
+	// With a tolerance of 0 it only stops once the terrain stops changing, and gives the same heights as updating every vertex
+	void SetThermalErosionConvergence(bool enabled, float tolerance = 0.0f);
+	const ThermalErosionStats& GetThermalErosionStats() const;
+
+	// Coarse-to-fine ParallelThermalErosion. The heights are averaged down into up to levels - 1 successively halved copies,
+	// then from the coarsest up each level is eroded for erosionIterations and the change is upsampled onto the next
+	// Material moves one cell per iteration at every level, so the coarse levels flatten the large slopes in far fewer passes
+	// The stats add up the iterations and vertices over every level
+	void PyramidThermalErosion(int erosionIterations, int levels);
+
+	// Hydraulic erosion simulates the effects of water on terrain over time by depositing droplets over terrain
+	// Results in ridged, rough terrain
+	// Droplets are placed on land vertices with rand(), seed it with srand() for repeatable results
+	// A droplet stops once it reaches a pit or runs off the map, or after iterations steps
+	// Reference implementation: https://github.com/vogtb/terrain-map/blob/master/landmap.js
+	void HydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence);
+
+	// HydraulicErosion with the droplets run on every thread. Start positions come from a counter-based generator seeded with
+	// seed, and the map is split into tiles wide enough that droplets from tiles two apart can't meet. The tiles are coloured
+	// like a 2x2 checkerboard and each colour's tiles run at the same time, so the result only depends on the seed
+	// The droplets run in a different order to HydraulicErosion, so the two don't give the same heights for the same drops
+	void ParallelHydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence,
+		unsigned int seed);
+	const HydraulicErosionStats& GetHydraulicErosionStats() const;
+
+	// Grid-based hydraulic erosion with the virtual pipe model of shallow water. Every vertex holds a depth of water, the flow
+	// through a pipe to each neighbour and the sediment suspended in the water, and all of them are stepped at once in passes
+	// over the rows. Each iteration rain falls, the flows accelerate down the water surface, the water moves, and water
+	// carrying less than carryingCapacity * slope * speed picks up depositionSpeed of the difference (or puts it down if
+	// carrying more). The sediment moves through the pipes with the water, and whatever is left settles at the end
+	// Takes the same time for any terrain. Only wall and wrap boundaries hold water, so clamp and mirror are treated as walls
+	// Reference: Mei, Decaudin and Hu, Fast Hydraulic Erosion Simulation and Visualization on GPU, 2007
+	void PipeHydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, float rainfall, float evaporation);
+
+	// Each vertex normal is the average of the normals of the faces around it, worked out straight from the heights in one
+	// pass over the rows
+	bool CalculateNormals();
+
+	// Recalculates only the normals that depend on the heights in rows [rowBegin, rowEnd) by columns [columnBegin, columnEnd),
+	// after a local edit. Calculates every normal the first time
+	bool CalculateNormals(int rowBegin, int rowEnd, int columnBegin, int columnEnd);
+
+private:
+
+	// Picks the octave specialisation of the fBm generator, then runs it over every row of each region
+	template <class Sampler, class Policy>
+	void GenerateHeightMapFbm(const Sampler& sampler, const FbmParams& params, float offsetY, const HeightMapRegion* regions, int regionCount);
+	template <class Sampler, class Policy, int Octaves>
+	void GenerateHeightMapRows(const Sampler& sampler, const FbmParams& params, float offsetY, const HeightMapRegion& region);
+
+	// Fills in any missing octave layers, then sums the weighted layers into the heightmap
+	template <class Sampler, class Policy>
+	void GenerateHeightMapCached(const Sampler& sampler, const FbmParams& params, float offsetY);
+
+	// Number of heightmap rows in each block handed to the thread pool
+	int RowsPerBlock(int rows) const;
+
+	// Works out how many cells the offsets have moved since the last heightmap, false if it can't be scrolled
+	// The offsets are snapped to the nearest whole cell, and the move is measured from the last full rebuild
+	bool FindScrollShift(const FbmParams& params, bool simplex, bool ridged, float offsetY, int& shiftX, int& shiftZ);
+
+	// Moves every height that stays in view to its new vertex
+	void ShiftHeightMap(int shiftX, int shiftZ);
+
+	// Stencil passes, specialised for each boundary policy
+	template <class Boundary>
+	void SmoothingPass(float smoothingWeight, float upperBound, float lowerBound);
+	template <class Boundary>
+	void SmoothingPassDoubleBuffered(float smoothingWeight, float upperBound, float lowerBound);
+	template <class Boundary>
+	void SeparableSmoothingPass(SmoothingFilter filter, int radius, int passes, float smoothingWeight, float upperBound, float lowerBound);
+
+	// Box filters one axis of a grid laid out like the heights into another, averaging 2 * radius + 1 vertices
+	template <class Boundary>
+	void BoxFilterRows(const float* source, float* destination, int radius);
+	template <class Boundary>
+	void BoxFilterColumns(const float* source, float* destination, int radius);
+
+	// Creates a zeroed grid the same size as the heights, including the ghost border
+	float* CreateGrid() const;
+
+	// Swaps the heights with the double buffer
+	void SwapHeights();
+	template <class Boundary>
+	void ThermalErosionPass(int erosionIterations);
+	template <class Boundary>
+	void ParallelThermalErosionPass(int erosionIterations);
+	template <class Boundary>
+	void ParallelThermalErosionTiles(int erosionIterations, float talus, float c, float* outflow, float* destination);
+
+	// Works out what the vertices in columns [columnBegin, columnEnd) of row j shed into outflow, returning whether any of them do
+	bool ThermalOutflowRow(int j, int columnBegin, int columnEnd, float talus, float c, float* outflow);
+
+	// Writes the eroded heights of columns [columnBegin, columnEnd) of row j to destination, returning the most any of them changed
+	float ThermalGatherRow(int j, int columnBegin, int columnEnd, float talus, const float* outflow, float* destination);
+
+	// Writes the normals of columns [columnBegin, columnEnd) of row j
+	void NormalsRow(int j, int columnBegin, int columnEnd);
+
+	// Normal of a vertex on the edge of the map, averaged over only the faces it has
+	void EdgeNormal(int i, int j);
+
+	// Sets the heights to the average of each 2x2 block of a field twice the resolution, rounded up
+	void DownsampleHeights(const HeightField& fine);
+
+	// Adds a grid laid out like the heights of a field half the resolution on, with bilinear filtering
+	void AddUpsampled(const float* coarse, int coarseResolution, int coarseStride);
+
+	// Lists every tile that is flagged or next to a flagged tile, returning how many there are
+	template <class Boundary>
+	int ListTiles(const char* flags, int tiles, char* listed, int* list);
+	template <class Boundary>
+	void HydraulicErosionPass(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence);
+	template <class Boundary>
+	void ParallelHydraulicErosionPass(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence,
+		unsigned int seed);
+
+	// Runs one droplet from vertex (X, Y), eroding and depositing along its path and adding what it did to stats
+	template <class Boundary>
+	void RunDroplet(int X, int Y, float carryingCapacity, float depositionSpeed, int iterations, float persistence,
+		HydraulicErosionStats& stats);
+
+	template <class Boundary>
+	void PipeHydraulicErosionPass(float carryingCapacity, float depositionSpeed, int iterations, float rainfall, float evaporation);
+
+	// Fills cells with the index (resolution * j) + i of every vertex above water, returning how many there are
+	int ListLandCells(int* cells) const;
+
+	static void ResetHydraulicStats(HydraulicErosionStats& stats);
+	static void FinishHydraulicStats(HydraulicErosionStats& stats);
+
+	// Fills the ghost cells around a grid laid out like the heights, walls are given wallValue
+	template <class Boundary>
+	void FillGhostCells(float* grid, float wallValue);
+
+	// Adds anything deposited on the height ghost cells since they were last filled onto the vertices they copy
+	template <class Boundary>
+	void FoldGhostCells();
+
+	// Copies vertex (i, j) into the edge ghost cells that copy it, after it has changed during a pass
+	template <class Boundary>
+	void RefreshGhostCells(int i, int j);
+
+	// Function for depositing sediment from the thermal erosion algorithm
+	float DepositSediment(float c, float maxDiff, float talus, float distance, float totalDiff);
+
+	int resolution;
+	int stride;					// Floats from one row of heights to the next, resolution plus a ghost cell either side
+	float* heightData;			// Heights including the ghost border
+	float* heights;				// First vertex inside the ghost border
+	float* ghostHeights;		// What FillGhostCells put in each ghost cell, in the order it fills them
+	float* swapData;			// Double buffer for the heights, created the first time a pass needs it
+	float* filterData;			// Second working grid, for SeparableSmoothing and the outflow of ParallelThermalErosion
+	bool smoothingDoubleBuffered;
+	bool thermalConvergence;
+	float thermalTolerance;
+	ThermalErosionStats thermalStats;
+	HydraulicErosionStats hydraulicStats;
+	BoundaryMode boundaryMode;
+	VectorType* normals;
+
+	// Pointers to the noise generation objects
+	ImprovedNoise* perlinNoiseGen;
+	SimplexNoise* simplexNoiseGen;
+
+	// Workers for splitting the heightmap up into blocks of rows
+	ThreadPool* threadPool;
+
+	// Unweighted octave layers, layerCacheOctaves layers of resolution * resolution heights
+	bool layerCacheEnabled;
+	LayerCacheKey layerCacheKey;
+	float* layerCache;
+	int layerCacheOctaves;
+
+	// Settings the current heights were generated with, for recognising a scroll
+	bool scrollEnabled;
+	bool scrollValid;			// Cleared when anything other than GenerateHeightMap changes the heights
+	FbmParams scrollParams;		// Offsets are those of the last full rebuild
+	int scrollCellsX;			// Whole cells scrolled since that rebuild, so the heights are at its offsets plus these
+	int scrollCellsZ;
+	float scrollOffsetY;
+	bool scrollSimplex, scrollRidged;
+
+	// Owns its heightmap and threads, so copying isn't allowed
+	HeightField(const HeightField&);
+	HeightField& operator=(const HeightField&);
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "HeightMapIO.h"
+#include <cstdio>
+#include <cstring>
+
+// Scales a height into the 16 bit range
+static unsigned short QuantiseHeight(float height, float minHeight, float maxHeight)
+{
+
+	float range = maxHeight - minHeight;
+	float t = range > 0.0f ? (height - minHeight) / range : 0.0f;
+
+	if (t < 0.0f)
+	{
+
+		t = 0.0f;
+
+	}
+
+	if (t > 1.0f)
+	{
+
+		t = 1.0f;
+
+	}
+
+	return (unsigned short)(t * 65535.0f + 0.5f);
+
+}
+
+// Writes every height as 16 bits, most significant byte first if bigEndian is set
+static bool WriteHeights16(const HeightField& field, FILE* file, float minHeight, float maxHeight, bool bigEndian)
+{
+
+	int resolution = field.GetResolution();
+	int stride = field.GetStride();
+	const float* heights = field.GetHeights();
+
+	// Write a row at a time
+	unsigned char* row = new unsigned char[resolution * 2];
+	bool ok = true;
+
+	for (int j = 0; j < resolution && ok; j++)
+	{
+
+		for (int i = 0; i < resolution; i++)
+		{
+
+			unsigned short value = QuantiseHeight(heights[(stride * j) + i], minHeight, maxHeight);
+
+			row[i * 2 + (bigEndian ? 0 : 1)] = (unsigned char)(value >> 8);
+			row[i * 2 + (bigEndian ? 1 : 0)] = (unsigned char)(value & 0xff);
+
+		}
+
+		ok = fwrite(row, 2, resolution, file) == (size_t)resolution;
+
+	}
+
+	delete[] row;
+
+	return ok;
+
+}
+
+void GetHeightRange(const HeightField& field, float& minHeight, float& maxHeight)
+{
+
+	int resolution = field.GetResolution();
+	int stride = field.GetStride();
+	const float* heights = field.GetHeights();
+
+	minHeight = heights[0];
+	maxHeight = heights[0];
+
+	for (int j = 0; j < resolution; j++)
+	{
+
+		for (int i = 0; i < resolution; i++)
+		{
+
+			float height = heights[(stride * j) + i];
+
+			if (height < minHeight)
+			{
+
+				minHeight = height;
+
+			}
+
+			if (height > maxHeight)
+			{
+
+				maxHeight = height;
+
+			}
+
+		}
+
+	}
+
+}
+
+bool WriteHeightMapR32(const HeightField& field, const char* path)
+{
+
+	FILE* file = fopen(path, "wb");
+
+	if (file == 0)
+	{
+
+		return false;
+
+	}
+
+	int resolution = field.GetResolution();
+	int stride = field.GetStride();
+	const float* heights = field.GetHeights();
+
+	// Write a row at a time, byte by byte so the file is little-endian whatever the platform
+	unsigned char* row = new unsigned char[resolution * 4];
+	bool ok = true;
+
+	for (int j = 0; j < resolution && ok; j++)
+	{
+
+		for (int i = 0; i < resolution; i++)
+		{
+
+			unsigned int bits;
+			memcpy(&bits, &heights[(stride * j) + i], 4);
+
+			row[i * 4] = (unsigned char)(bits & 0xff);
+			row[i * 4 + 1] = (unsigned char)((bits >> 8) & 0xff);
+			row[i * 4 + 2] = (unsigned char)((bits >> 16) & 0xff);
+			row[i * 4 + 3] = (unsigned char)(bits >> 24);
+
+		}
+
+		ok = fwrite(row, 4, resolution, file) == (size_t)resolution;
+
+	}
+
+	delete[] row;
+
+	return fclose(file) == 0 && ok;
+
+}
+
+bool WriteHeightMapR16(const HeightField& field, const char* path, float minHeight, float maxHeight)
+{
+
+	FILE* file = fopen(path, "wb");
+
+	if (file == 0)
+	{
+
+		return false;
+
+	}
+
+	bool ok = WriteHeights16(field, file, minHeight, maxHeight, false);
+
+	return fclose(file) == 0 && ok;
+
+}
+
+bool WriteHeightMapPGM(const HeightField& field, const char* path, float minHeight, float maxHeight)
+{
+
+	FILE* file = fopen(path, "wb");
+
+	if (file == 0)
+	{
+
+		return false;
+
+	}
+
+	bool ok = fprintf(file, "P5\n%d %d\n65535\n", field.GetResolution(), field.GetResolution()) > 0;
+	ok = ok && WriteHeights16(field, file, minHeight, maxHeight, true);
+
+	return fclose(file) == 0 && ok;
+
+}
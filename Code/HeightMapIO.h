@@ -0,0 +1,18 @@
+// HeightMapIO.h
+// Writes heightfields out to image formats terrain tools and engines can read.
+// 16 bit formats map heights between minHeight and maxHeight onto 0 to 65535, clamping anything outside that range.
+
+#pragma once
+#include "HeightField.h"
+
+// Finds the lowest and highest heights in the heightfield
+void GetHeightRange(const HeightField& field, float& minHeight, float& maxHeight);
+
+// Raw little-endian 32 bit floats, one per vertex in row order
+bool WriteHeightMapR32(const HeightField& field, const char* path);
+
+// Raw little-endian 16 bit unsigned heights, one per vertex in row order
+bool WriteHeightMapR16(const HeightField& field, const char* path, float minHeight, float maxHeight);
+
+// Binary 16 bit greyscale PGM (P5, big-endian as the format requires)
+bool WriteHeightMapPGM(const HeightField& field, const char* path, float minHeight, float maxHeight);
@@ -1,40 +1,61 @@
 #include "ImprovedNoise.h"
+#include "NoiseBatch.h"
 
+// Picks up the float overload of floor for ImprovedNoiseF
+using std::floor;
 
 
-ImprovedNoise::ImprovedNoise()
+
+template <typename T>
+ImprovedNoiseT<T>::ImprovedNoiseT()
 {
 
 	for (int i = 0; i < 256; i++) p[256 + i] = p[i] = permutation[i];
 
 }
 
-double ImprovedNoise::fade(double t)
+template <typename T>
+T ImprovedNoiseT<T>::fade(T t)
 { 
 	
-	return t * t * t * (t * (t * 6 - 15) + 10); 
+	return t * t * t * (t * (t * T(6) - T(15)) + T(10)); 
 
 }
 
-double ImprovedNoise::lerp(double t, double a, double b)
+template <typename T>
+T ImprovedNoiseT<T>::lerp(T t, T a, T b)
 { 
 	
 	return a + t * (b - a); 
 
 }
 
-double ImprovedNoise::grad(int hash, double x, double y, double z) {
+template <typename T>
+T ImprovedNoiseT<T>::grad(int hash, T x, T y, T z) {
 
 	int h = hash & 15;										 // CONVERT LO 4 BITS OF HASH CODE
 
-	double u = h<8 ? x : y,									 // INTO 12 GRADIENT DIRECTIONS.
+	T u = h<8 ? x : y,										 // INTO 12 GRADIENT DIRECTIONS.
 		v = h<4 ? y : h == 12 || h == 14 ? x : z;
 
 	return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
 
 }
 
-double ImprovedNoise::noise(double x, double y, double z) {
+template <typename T>
+T ImprovedNoiseT<T>::grad2D(int hash, T x, T z) {
+
+	int h = hash & 15;										 // SAME 12 GRADIENT DIRECTIONS AS
+															 // grad, WITH Y = 0.
+	T u = h<8 ? x : T(0),
+		v = h<4 ? T(0) : h == 12 || h == 14 ? x : z;
+
+	return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+
+}
+
+template <typename T>
+T ImprovedNoiseT<T>::noise(T x, T y, T z) {
 
 	int X = (int)floor(x) & 255,							// FIND UNIT CUBE THAT
 		Y = (int)floor(y) & 255,							// CONTAINS POINT.
@@ -42,7 +63,7 @@ double ImprovedNoise::noise(double x, double y, double z) {
 	x -= floor(x);											// FIND RELATIVE X,Y,Z
 	y -= floor(y);											// OF POINT IN CUBE.
 	z -= floor(z);
-	double u = fade(x),										// COMPUTE FADE CURVES
+	T u = fade(x),											// COMPUTE FADE CURVES
 		v = fade(y),										// FOR EACH OF X,Y,Z.
 		w = fade(z);
 	int A = p[X] + Y, 
@@ -61,4 +82,81 @@ double ImprovedNoise::noise(double x, double y, double z) {
 			lerp(u, grad(p[AB + 1], x, y - 1, z - 1),
 				grad(p[BB + 1], x - 1, y - 1, z - 1))));
 
-}
\ No newline at end of file
+}
+
+template <typename T>
+void ImprovedNoiseT<T>::noise(const float* x, const float* y, const float* z, float* out, int count)
+{
+
+	BatchPerlinNoise3D(p, x, y, z, out, count);
+
+}
+
+template <typename T>
+T ImprovedNoiseT<T>::noise2D(T x, T z, int plane) {
+
+	int X = (int)floor(x) & 255,							// FIND UNIT SQUARE THAT
+		Y = plane & 255,									// CONTAINS POINT ON
+		Z = (int)floor(z) & 255;							// THE PLANE.
+	x -= floor(x);											// FIND RELATIVE X,Z
+	z -= floor(z);											// OF POINT IN SQUARE.
+	T u = fade(x),											// COMPUTE FADE CURVES
+		w = fade(z);										// FOR EACH OF X,Z.
+	int AA = p[p[X] + Y] + Z,								// HASH COORDINATES OF
+		BA = p[p[X + 1] + Y] + Z;							// THE 4 SQUARE CORNERS,
+
+	return lerp(w, lerp(u, grad2D(p[AA], x, z),				// AND ADD BLENDED
+		grad2D(p[BA], x - 1, z)),							// RESULTS FROM 4
+		lerp(u, grad2D(p[AA + 1], x, z - 1),				// CORNERS OF SQUARE
+			grad2D(p[BA + 1], x - 1, z - 1)));
+
+}
+
+template <typename T>
+void ImprovedNoiseT<T>::noise2D(const float* x, const float* z, int plane, float* out, int count)
+{
+
+	BatchPerlinNoise2D(p, x, z, plane, out, count);
+
+}
+
+template <typename T>
+void ImprovedNoiseT<T>::noise2DDual(T x, T z, int planeA, int planeB, T& outA, T& outB) {
+
+	int X = (int)floor(x) & 255,							// FIND UNIT SQUARE THAT
+		Z = (int)floor(z) & 255;							// CONTAINS POINT.
+	x -= floor(x);											// FIND RELATIVE X,Z
+	z -= floor(z);											// OF POINT IN SQUARE.
+	T u = fade(x),											// COMPUTE FADE CURVES
+		w = fade(z);										// FOR EACH OF X,Z.
+	int A = p[X],											// FIRST LEVEL OF THE HASH
+		B = p[X + 1];										// IS SHARED BY BOTH PLANES.
+
+	int AA = p[A + (planeA & 255)] + Z,						// HASH COORDINATES OF
+		BA = p[B + (planeA & 255)] + Z;						// THE 4 CORNERS ON EACH PLANE,
+
+	outA = lerp(w, lerp(u, grad2D(p[AA], x, z),				// AND ADD BLENDED
+		grad2D(p[BA], x - 1, z)),							// RESULTS FROM 4
+		lerp(u, grad2D(p[AA + 1], x, z - 1),				// CORNERS OF SQUARE
+			grad2D(p[BA + 1], x - 1, z - 1)));
+
+	AA = p[A + (planeB & 255)] + Z;
+	BA = p[B + (planeB & 255)] + Z;
+
+	outB = lerp(w, lerp(u, grad2D(p[AA], x, z),
+		grad2D(p[BA], x - 1, z)),
+		lerp(u, grad2D(p[AA + 1], x, z - 1),
+			grad2D(p[BA + 1], x - 1, z - 1)));
+
+}
+
+template <typename T>
+void ImprovedNoiseT<T>::noise2DDual(const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	BatchPerlinNoise2DDual(p, x, z, planeA, planeB, outA, outB, count);
+
+}
+
+template class ImprovedNoiseT<double>;
+template class ImprovedNoiseT<float>;
\ No newline at end of file
@@ -1,23 +1,38 @@
 // Improved Perlin noise generator
 // Adapted from Perlin's Java reference implementation found here: http://mrl.nyu.edu/~perlin/noise/
 // Returns deterministic noise value for a single reference point
+// Templated on the scalar type, ImprovedNoiseF works entirely in single precision for float-only pipelines
 
 #pragma once
 #include <cmath>
 
-class ImprovedNoise {
+template <typename T>
+class ImprovedNoiseT {
 
 public:
 
-	ImprovedNoise();
+	ImprovedNoiseT();
 
-	double noise(double x, double y, double z);
+	T noise(T x, T y, T z);
+
+	// Batched noise for a row of points, evaluated in single precision using SIMD where available (see NoiseBatch.h)
+	void noise(const float* x, const float* y, const float* z, float* out, int count);
+
+	// 2D noise across the integer y plane given by plane, equal to noise(x, plane, z)
+	// Only the 4 corners of a square are hashed instead of the 8 corners of a cube
+	T noise2D(T x, T z, int plane = 0);
+	void noise2D(const float* x, const float* z, int plane, float* out, int count);
+
+	// 2D noise on two planes at once, the square, fade curves and first level of hashing are shared between them
+	void noise2DDual(T x, T z, int planeA, int planeB, T& outA, T& outB);
+	void noise2DDual(const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count);
 
 private:
 
-	double fade(double t);
-	double lerp(double t, double a, double b);
-	double grad(int hash, double x, double y, double z);
+	T fade(T t);
+	T lerp(T t, T a, T b);
+	T grad(int hash, T x, T y, T z);
+	T grad2D(int hash, T x, T z);
 
 	int p[512];
 
@@ -36,4 +51,9 @@ private:
 		138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
 	};
 
-};
\ No newline at end of file
+};
+
+// The double precision generator is the reference, the float one agrees with it to within NOISE_BATCH_TOLERANCE (see NoiseBatch.h)
+// Tests/NoiseTests.cpp holds it to 2.5e-6 for coordinates up to 65536 in magnitude
+typedef ImprovedNoiseT<double> ImprovedNoise;
+typedef ImprovedNoiseT<float> ImprovedNoiseF;
\ No newline at end of file
@@ -0,0 +1,117 @@
+// NoiseAVX2.cpp
+// AVX2 instantiation of the batched noise kernels, eight points per iteration
+// The whole translation unit is compiled for AVX2 and is only ever called after NoiseBatch.cpp has checked the CPU supports it
+
+#include "NoiseBatch.h"
+
+#if defined(NOISE_BATCH_X86)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include <immintrin.h>
+#include "NoiseKernels.h"
+
+struct AVX2Ops
+{
+
+	typedef __m256 F;
+	typedef __m256i I;
+	typedef __m256 M;
+
+	static const int Width = 8;
+
+	static F Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, F a) { _mm256_storeu_ps(p, a); }
+	static F Set(float a) { return _mm256_set1_ps(a); }
+	static I SetI(int a) { return _mm256_set1_epi32(a); }
+
+	static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static F Max(F a, F b) { return _mm256_max_ps(a, b); }
+	static F Floor(F a) { return _mm256_floor_ps(a); }
+	static I ToInt(F a) { return _mm256_cvttps_epi32(a); }
+
+	static I AddI(I a, I b) { return _mm256_add_epi32(a, b); }
+	static I AndI(I a, I b) { return _mm256_and_si256(a, b); }
+
+	static I Gather(const int* table, I index) { return _mm256_i32gather_epi32(table, index, 4); }
+	static F GatherF(const float* table, I index) { return _mm256_i32gather_ps(table, index, 4); }
+
+	static M LessI(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+	static M EqualI(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+	static M GreaterEqual(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static M And(M a, M b) { return _mm256_and_ps(a, b); }
+	static M Or(M a, M b) { return _mm256_or_ps(a, b); }
+	static M Not(M a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+	static F Select(M mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+	static F MaskToOne(M mask) { return _mm256_and_ps(mask, _mm256_set1_ps(1.0f)); }
+
+	// Negate the lanes where bit is non-zero
+	static F FlipSign(F a, I bit)
+	{
+
+		I sign = _mm256_andnot_si256(_mm256_cmpeq_epi32(bit, _mm256_setzero_si256()), _mm256_set1_epi32((int)0x80000000));
+		return _mm256_xor_ps(a, _mm256_castsi256_ps(sign));
+
+	}
+
+};
+
+int PerlinNoise3DAVX2(const int* p, const float* x, const float* y, const float* z, float* out, int count)
+{
+
+	return PerlinNoise3DKernel<AVX2Ops>(p, x, y, z, out, count);
+
+}
+
+int SimplexNoise3DAVX2(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, const float* z, float* out, int count)
+{
+
+	return SimplexNoise3DKernel<AVX2Ops>(perm, permMod12, grad, x, y, z, out, count);
+
+}
+
+int PerlinNoise2DAVX2(const int* p, const float* x, const float* z, int plane, float* out, int count)
+{
+
+	return PerlinNoise2DKernel<AVX2Ops>(p, x, z, plane, out, count);
+
+}
+
+int SimplexNoise2DAVX2(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, int plane, float* out, int count)
+{
+
+	return SimplexNoise2DKernel<AVX2Ops>(perm, permMod12, grad, x, y, plane, out, count);
+
+}
+
+int PerlinNoise2DDualAVX2(const int* p, const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	return PerlinNoise2DDualKernel<AVX2Ops>(p, x, z, planeA, planeB, outA, outB, count);
+
+}
+
+int SimplexNoise2DDualAVX2(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	return SimplexNoise2DDualKernel<AVX2Ops>(perm, permMod12, grad, x, y, planeA, planeB, outA, outB, count);
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
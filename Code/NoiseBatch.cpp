@@ -0,0 +1,331 @@
+#include "NoiseBatch.h"
+#include "NoiseKernels.h"
+#include <cmath>
+
+#if defined(NOISE_BATCH_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+// One lane version of the kernel operations, used on CPUs without SSE4.1 and for the tail of every batch
+struct ScalarOps
+{
+
+	typedef float F;
+	typedef int I;
+	typedef bool M;
+
+	static const int Width = 1;
+
+	static F Load(const float* p) { return *p; }
+	static void Store(float* p, F a) { *p = a; }
+	static F Set(float a) { return a; }
+	static I SetI(int a) { return a; }
+
+	static F Add(F a, F b) { return a + b; }
+	static F Sub(F a, F b) { return a - b; }
+	static F Mul(F a, F b) { return a * b; }
+	static F Max(F a, F b) { return a > b ? a : b; }
+	static F Floor(F a) { return std::floor(a); }
+	static I ToInt(F a) { return (int)a; }
+
+	static I AddI(I a, I b) { return a + b; }
+	static I AndI(I a, I b) { return a & b; }
+
+	static I Gather(const int* table, I index) { return table[index]; }
+	static F GatherF(const float* table, I index) { return table[index]; }
+
+	static M LessI(I a, I b) { return a < b; }
+	static M EqualI(I a, I b) { return a == b; }
+	static M GreaterEqual(F a, F b) { return a >= b; }
+	static M And(M a, M b) { return a && b; }
+	static M Or(M a, M b) { return a || b; }
+	static M Not(M a) { return !a; }
+	static F Select(M mask, F a, F b) { return mask ? a : b; }
+	static F MaskToOne(M mask) { return mask ? 1.0f : 0.0f; }
+	static F FlipSign(F a, I bit) { return bit != 0 ? -a : a; }
+
+};
+
+#if defined(NOISE_BATCH_X86)
+
+// Entry points defined in NoiseSSE41.cpp and NoiseAVX2.cpp, each returns the number of points it processed
+int PerlinNoise3DSSE41(const int* p, const float* x, const float* y, const float* z, float* out, int count);
+int SimplexNoise3DSSE41(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, const float* z, float* out, int count);
+int PerlinNoise3DAVX2(const int* p, const float* x, const float* y, const float* z, float* out, int count);
+int SimplexNoise3DAVX2(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, const float* z, float* out, int count);
+int PerlinNoise2DSSE41(const int* p, const float* x, const float* z, int plane, float* out, int count);
+int SimplexNoise2DSSE41(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, int plane, float* out, int count);
+int PerlinNoise2DDualSSE41(const int* p, const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count);
+int SimplexNoise2DDualSSE41(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, int planeA, int planeB, float* outA, float* outB, int count);
+int PerlinNoise2DAVX2(const int* p, const float* x, const float* z, int plane, float* out, int count);
+int SimplexNoise2DAVX2(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, int plane, float* out, int count);
+int PerlinNoise2DDualAVX2(const int* p, const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count);
+int SimplexNoise2DDualAVX2(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, int planeA, int planeB, float* outA, float* outB, int count);
+
+#if defined(_MSC_VER)
+
+static bool CpuSupportsSSE41()
+{
+
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 19)) != 0;
+
+}
+
+static bool CpuSupportsAVX2()
+{
+
+	int info[4];
+	__cpuid(info, 0);
+
+	if (info[0] < 7)
+	{
+
+		return false;
+
+	}
+
+	// The OS must also save the upper halves of the YMM registers on a context switch
+	__cpuid(info, 1);
+
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+	{
+
+		return false;
+
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+
+}
+
+#else
+
+static bool CpuSupportsSSE41()
+{
+
+	return __builtin_cpu_supports("sse4.1") != 0;
+
+}
+
+static bool CpuSupportsAVX2()
+{
+
+	return __builtin_cpu_supports("avx2") != 0;
+
+}
+
+#endif
+
+#else
+
+static bool CpuSupportsSSE41()
+{
+
+	return false;
+
+}
+
+static bool CpuSupportsAVX2()
+{
+
+	return false;
+
+}
+
+#endif
+
+// Wide kernels for the selected instruction set, null when running scalar code only
+struct NoiseKernelTable
+{
+
+	NoiseInstructionSet instructionSet;
+	int(*perlin3D)(const int* p, const float* x, const float* y, const float* z, float* out, int count);
+	int(*simplex3D)(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+		const float* x, const float* y, const float* z, float* out, int count);
+	int(*perlin2D)(const int* p, const float* x, const float* z, int plane, float* out, int count);
+	int(*simplex2D)(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+		const float* x, const float* y, int plane, float* out, int count);
+	int(*perlin2DDual)(const int* p, const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count);
+	int(*simplex2DDual)(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+		const float* x, const float* y, int planeA, int planeB, float* outA, float* outB, int count);
+
+};
+
+static NoiseKernelTable BuildKernelTable(NoiseInstructionSet requested)
+{
+
+	NoiseKernelTable table = { NOISE_SCALAR, 0, 0, 0, 0, 0, 0 };
+
+#if defined(NOISE_BATCH_X86)
+	if (requested >= NOISE_AVX2 && CpuSupportsAVX2())
+	{
+
+		table.instructionSet = NOISE_AVX2;
+		table.perlin3D = PerlinNoise3DAVX2;
+		table.simplex3D = SimplexNoise3DAVX2;
+		table.perlin2D = PerlinNoise2DAVX2;
+		table.simplex2D = SimplexNoise2DAVX2;
+		table.perlin2DDual = PerlinNoise2DDualAVX2;
+		table.simplex2DDual = SimplexNoise2DDualAVX2;
+
+	}
+	else if (requested >= NOISE_SSE41 && CpuSupportsSSE41())
+	{
+
+		table.instructionSet = NOISE_SSE41;
+		table.perlin3D = PerlinNoise3DSSE41;
+		table.simplex3D = SimplexNoise3DSSE41;
+		table.perlin2D = PerlinNoise2DSSE41;
+		table.simplex2D = SimplexNoise2DSSE41;
+		table.perlin2DDual = PerlinNoise2DDualSSE41;
+		table.simplex2DDual = SimplexNoise2DDualSSE41;
+
+	}
+#endif
+
+	return table;
+
+}
+
+static NoiseKernelTable& GetKernelTable()
+{
+
+	static NoiseKernelTable table = BuildKernelTable(NOISE_AVX2);
+	return table;
+
+}
+
+// Gradients for Simplex noise, split into components so the wide kernels can gather them
+static const SimplexGradientTable simplexGradients = {
+	{ 1, -1, 1, -1, 1, -1, 1, -1, 0, 0, 0, 0 },
+	{ 1, 1, -1, -1, 0, 0, 0, 0, 1, -1, 1, -1 },
+	{ 0, 0, 0, 0, 1, 1, -1, -1, 1, 1, -1, -1 }
+};
+
+NoiseInstructionSet GetNoiseInstructionSet()
+{
+
+	return GetKernelTable().instructionSet;
+
+}
+
+void SetNoiseInstructionSet(NoiseInstructionSet instructionSet)
+{
+
+	GetKernelTable() = BuildKernelTable(instructionSet);
+
+}
+
+void BatchPerlinNoise3D(const int* p, const float* x, const float* y, const float* z, float* out, int count)
+{
+
+	const NoiseKernelTable& table = GetKernelTable();
+	int done = 0;
+
+	if (table.perlin3D)
+	{
+
+		done = table.perlin3D(p, x, y, z, out, count);
+
+	}
+
+	// Finish off any points that don't fill a whole vector
+	PerlinNoise3DKernel<ScalarOps>(p, x + done, y + done, z + done, out + done, count - done);
+
+}
+
+void BatchSimplexNoise3D(const int* perm, const int* permMod12, const float* x, const float* y, const float* z, float* out, int count)
+{
+
+	const NoiseKernelTable& table = GetKernelTable();
+	int done = 0;
+
+	if (table.simplex3D)
+	{
+
+		done = table.simplex3D(perm, permMod12, simplexGradients, x, y, z, out, count);
+
+	}
+
+	SimplexNoise3DKernel<ScalarOps>(perm, permMod12, simplexGradients, x + done, y + done, z + done, out + done, count - done);
+
+}
+
+void BatchPerlinNoise2D(const int* p, const float* x, const float* z, int plane, float* out, int count)
+{
+
+	const NoiseKernelTable& table = GetKernelTable();
+	int done = 0;
+
+	if (table.perlin2D)
+	{
+
+		done = table.perlin2D(p, x, z, plane, out, count);
+
+	}
+
+	PerlinNoise2DKernel<ScalarOps>(p, x + done, z + done, plane, out + done, count - done);
+
+}
+
+void BatchSimplexNoise2D(const int* perm, const int* permMod12, const float* x, const float* y, int plane, float* out, int count)
+{
+
+	const NoiseKernelTable& table = GetKernelTable();
+	int done = 0;
+
+	if (table.simplex2D)
+	{
+
+		done = table.simplex2D(perm, permMod12, simplexGradients, x, y, plane, out, count);
+
+	}
+
+	SimplexNoise2DKernel<ScalarOps>(perm, permMod12, simplexGradients, x + done, y + done, plane, out + done, count - done);
+
+}
+
+void BatchPerlinNoise2DDual(const int* p, const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	const NoiseKernelTable& table = GetKernelTable();
+	int done = 0;
+
+	if (table.perlin2DDual)
+	{
+
+		done = table.perlin2DDual(p, x, z, planeA, planeB, outA, outB, count);
+
+	}
+
+	PerlinNoise2DDualKernel<ScalarOps>(p, x + done, z + done, planeA, planeB, outA + done, outB + done, count - done);
+
+}
+
+void BatchSimplexNoise2DDual(const int* perm, const int* permMod12, const float* x, const float* y, int planeA, int planeB,
+	float* outA, float* outB, int count)
+{
+
+	const NoiseKernelTable& table = GetKernelTable();
+	int done = 0;
+
+	if (table.simplex2DDual)
+	{
+
+		done = table.simplex2DDual(perm, permMod12, simplexGradients, x, y, planeA, planeB, outA, outB, count);
+
+	}
+
+	SimplexNoise2DDualKernel<ScalarOps>(perm, permMod12, simplexGradients, x + done, y + done, planeA, planeB, outA + done, outB + done, count - done);
+
+}
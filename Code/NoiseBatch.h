@@ -0,0 +1,52 @@
+// NoiseBatch.h
+// Batched noise evaluation for rows of sample points.
+// The widest instruction set supported by the CPU (AVX2, then SSE4.1, then plain scalar code) is picked the first time a batch is run.
+// Every path performs the same single precision arithmetic, so the result does not depend on which one was picked,
+// and agrees with the scalar double precision noise functions to within NOISE_BATCH_TOLERANCE for coordinates below 65536 in magnitude.
+// The one exception is 3D Simplex noise right on the boundary between two simplices: the 0.6 falloff radius makes the
+// reference function slightly discontinuous there, so a rounding difference in picking the simplex can move the result
+// by up to NOISE_BATCH_SIMPLEX_SEAM_TOLERANCE.
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NOISE_BATCH_X86 1
+#endif
+
+// Maximum absolute difference between a batched result and the matching double precision noise function
+#define NOISE_BATCH_TOLERANCE 1e-5
+#define NOISE_BATCH_SIMPLEX_SEAM_TOLERANCE 5e-3
+
+enum NoiseInstructionSet
+{
+
+	NOISE_SCALAR,
+	NOISE_SSE41,
+	NOISE_AVX2
+
+};
+
+// Returns the instruction set currently used by the batched kernels
+NoiseInstructionSet GetNoiseInstructionSet();
+
+// Forces the batched kernels onto a particular instruction set, e.g. to compare the paths against each other
+// Requests for a set the CPU does not support fall back to the best one that it does
+// Not thread safe, call this before any noise is evaluated
+void SetNoiseInstructionSet(NoiseInstructionSet instructionSet);
+
+// Batched 3D Improved Perlin noise, p is the doubled 512 entry permutation table
+void BatchPerlinNoise3D(const int* p, const float* x, const float* y, const float* z, float* out, int count);
+
+// Batched 3D Simplex noise, perm and permMod12 are the doubled 512 entry permutation tables
+void BatchSimplexNoise3D(const int* perm, const int* permMod12, const float* x, const float* y, const float* z, float* out, int count);
+
+// Batched 2D Improved Perlin noise on the integer y plane given by plane, equal to the 3D version at y = plane
+void BatchPerlinNoise2D(const int* p, const float* x, const float* z, int plane, float* out, int count);
+
+// Batched 2D Simplex noise, plane selects an independent layer of noise
+void BatchSimplexNoise2D(const int* perm, const int* permMod12, const float* x, const float* y, int plane, float* out, int count);
+
+// Batched 2D noise on two planes at once, sharing all of the work that doesn't depend on the plane
+void BatchPerlinNoise2DDual(const int* p, const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count);
+void BatchSimplexNoise2DDual(const int* perm, const int* permMod12, const float* x, const float* y, int planeA, int planeB,
+	float* outA, float* outB, int count);
@@ -0,0 +1,557 @@
+// NoiseKernels.h
+// Lane-generic versions of the Improved Perlin and Simplex noise functions used by the batched noise API.
+// Each kernel is written once against an Ops policy which supplies the vector types and operations for an instruction set
+// (plain scalar code, SSE4.1 or AVX2), so every path performs exactly the same single precision arithmetic.
+// This header is included from translation units compiled for different target instruction sets,
+// so it must not include any other headers.
+
+#pragma once
+
+// Gradient component tables for Simplex noise, matching SimplexNoise::grad3
+struct SimplexGradientTable
+{
+
+	float x[12];
+	float y[12];
+	float z[12];
+
+};
+
+// Perlin's quintic fade curve, 6t^5 - 15t^4 + 10t^3
+template <class Ops>
+inline typename Ops::F NoiseFade(typename Ops::F t)
+{
+
+	typedef typename Ops::F F;
+
+	F inner = Ops::Add(Ops::Mul(t, Ops::Sub(Ops::Mul(t, Ops::Set(6.0f)), Ops::Set(15.0f))), Ops::Set(10.0f));
+	return Ops::Mul(Ops::Mul(Ops::Mul(t, t), t), inner);
+
+}
+
+template <class Ops>
+inline typename Ops::F NoiseLerp(typename Ops::F t, typename Ops::F a, typename Ops::F b)
+{
+
+	return Ops::Add(a, Ops::Mul(t, Ops::Sub(b, a)));
+
+}
+
+// Branch-free equivalent of ImprovedNoise::grad, selecting one of 12 gradient directions from the low 4 bits of the hash
+template <class Ops>
+inline typename Ops::F PerlinGrad(typename Ops::I hash, typename Ops::F x, typename Ops::F y, typename Ops::F z)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	I h = Ops::AndI(hash, Ops::SetI(15));
+
+	F u = Ops::Select(Ops::LessI(h, Ops::SetI(8)), x, y);
+	F v = Ops::Select(Ops::LessI(h, Ops::SetI(4)), y,
+		Ops::Select(Ops::Or(Ops::EqualI(h, Ops::SetI(12)), Ops::EqualI(h, Ops::SetI(14))), x, z));
+
+	return Ops::Add(Ops::FlipSign(u, Ops::AndI(h, Ops::SetI(1))), Ops::FlipSign(v, Ops::AndI(h, Ops::SetI(2))));
+
+}
+
+// 3D Improved Perlin noise for every full vector of points, returns the number of points processed
+// p is the doubled 512 entry permutation table from ImprovedNoise
+template <class Ops>
+int PerlinNoise3DKernel(const int* p, const float* xs, const float* ys, const float* zs, float* out, int count)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	const I one = Ops::SetI(1);
+	const I mask = Ops::SetI(255);
+	const F fone = Ops::Set(1.0f);
+
+	int n = 0;
+
+	for (; n + Ops::Width <= count; n += Ops::Width)
+	{
+
+		F x = Ops::Load(xs + n);
+		F y = Ops::Load(ys + n);
+		F z = Ops::Load(zs + n);
+
+		// Find unit cube that contains point
+		F fx = Ops::Floor(x);
+		F fy = Ops::Floor(y);
+		F fz = Ops::Floor(z);
+		I X = Ops::AndI(Ops::ToInt(fx), mask);
+		I Y = Ops::AndI(Ops::ToInt(fy), mask);
+		I Z = Ops::AndI(Ops::ToInt(fz), mask);
+
+		// Find relative x, y, z of point in cube
+		x = Ops::Sub(x, fx);
+		y = Ops::Sub(y, fy);
+		z = Ops::Sub(z, fz);
+		F x1 = Ops::Sub(x, fone);
+		F y1 = Ops::Sub(y, fone);
+		F z1 = Ops::Sub(z, fone);
+
+		// Compute fade curves for each of x, y, z
+		F u = NoiseFade<Ops>(x);
+		F v = NoiseFade<Ops>(y);
+		F w = NoiseFade<Ops>(z);
+
+		// Hash coordinates of the 8 cube corners
+		I A = Ops::AddI(Ops::Gather(p, X), Y);
+		I AA = Ops::AddI(Ops::Gather(p, A), Z);
+		I AB = Ops::AddI(Ops::Gather(p, Ops::AddI(A, one)), Z);
+		I B = Ops::AddI(Ops::Gather(p, Ops::AddI(X, one)), Y);
+		I BA = Ops::AddI(Ops::Gather(p, B), Z);
+		I BB = Ops::AddI(Ops::Gather(p, Ops::AddI(B, one)), Z);
+
+		// And add blended results from the 8 corners of the cube
+		F result = NoiseLerp<Ops>(w,
+			NoiseLerp<Ops>(v,
+				NoiseLerp<Ops>(u, PerlinGrad<Ops>(Ops::Gather(p, AA), x, y, z), PerlinGrad<Ops>(Ops::Gather(p, BA), x1, y, z)),
+				NoiseLerp<Ops>(u, PerlinGrad<Ops>(Ops::Gather(p, AB), x, y1, z), PerlinGrad<Ops>(Ops::Gather(p, BB), x1, y1, z))),
+			NoiseLerp<Ops>(v,
+				NoiseLerp<Ops>(u, PerlinGrad<Ops>(Ops::Gather(p, Ops::AddI(AA, one)), x, y, z1), PerlinGrad<Ops>(Ops::Gather(p, Ops::AddI(BA, one)), x1, y, z1)),
+				NoiseLerp<Ops>(u, PerlinGrad<Ops>(Ops::Gather(p, Ops::AddI(AB, one)), x, y1, z1), PerlinGrad<Ops>(Ops::Gather(p, Ops::AddI(BB, one)), x1, y1, z1))));
+
+		Ops::Store(out + n, result);
+
+	}
+
+	return n;
+
+}
+
+// Gradient for a point on an integer y plane, equivalent to PerlinGrad with y = 0
+template <class Ops>
+inline typename Ops::F PerlinGrad2D(typename Ops::I hash, typename Ops::F x, typename Ops::F z)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	I h = Ops::AndI(hash, Ops::SetI(15));
+	F zero = Ops::Set(0.0f);
+
+	F u = Ops::Select(Ops::LessI(h, Ops::SetI(8)), x, zero);
+	F v = Ops::Select(Ops::LessI(h, Ops::SetI(4)), zero,
+		Ops::Select(Ops::Or(Ops::EqualI(h, Ops::SetI(12)), Ops::EqualI(h, Ops::SetI(14))), x, z));
+
+	return Ops::Add(Ops::FlipSign(u, Ops::AndI(h, Ops::SetI(1))), Ops::FlipSign(v, Ops::AndI(h, Ops::SetI(2))));
+
+}
+
+// Blended gradients from the 4 corners of the square on one integer y plane
+// pX and pX1 are the first level of the permutation hash, p[X] and p[X + 1], which don't depend on the plane
+template <class Ops>
+inline typename Ops::F PerlinPlane2D(const int* p, typename Ops::I pX, typename Ops::I pX1, typename Ops::I Y, typename Ops::I Z,
+	typename Ops::F x, typename Ops::F z, typename Ops::F u, typename Ops::F w)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	const I one = Ops::SetI(1);
+	const F fone = Ops::Set(1.0f);
+
+	F x1 = Ops::Sub(x, fone);
+	F z1 = Ops::Sub(z, fone);
+
+	// Hash coordinates of the 4 square corners
+	I AA = Ops::AddI(Ops::Gather(p, Ops::AddI(pX, Y)), Z);
+	I BA = Ops::AddI(Ops::Gather(p, Ops::AddI(pX1, Y)), Z);
+
+	// And add blended results from the 4 corners of the square
+	return NoiseLerp<Ops>(w,
+		NoiseLerp<Ops>(u, PerlinGrad2D<Ops>(Ops::Gather(p, AA), x, z), PerlinGrad2D<Ops>(Ops::Gather(p, BA), x1, z)),
+		NoiseLerp<Ops>(u, PerlinGrad2D<Ops>(Ops::Gather(p, Ops::AddI(AA, one)), x, z1), PerlinGrad2D<Ops>(Ops::Gather(p, Ops::AddI(BA, one)), x1, z1)));
+
+}
+
+// 2D Improved Perlin noise on the integer y plane given by plane, returns the number of points processed
+// Only the 4 corners of the square on that plane are hashed, the other 4 corners of the cube have no weight there
+template <class Ops>
+int PerlinNoise2DKernel(const int* p, const float* xs, const float* zs, int plane, float* out, int count)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	const I one = Ops::SetI(1);
+	const I mask = Ops::SetI(255);
+	const I Y = Ops::SetI(plane & 255);
+
+	int n = 0;
+
+	for (; n + Ops::Width <= count; n += Ops::Width)
+	{
+
+		F x = Ops::Load(xs + n);
+		F z = Ops::Load(zs + n);
+
+		// Find unit square that contains point
+		F fx = Ops::Floor(x);
+		F fz = Ops::Floor(z);
+		I X = Ops::AndI(Ops::ToInt(fx), mask);
+		I Z = Ops::AndI(Ops::ToInt(fz), mask);
+
+		// Find relative x, z of point in square and compute fade curves
+		x = Ops::Sub(x, fx);
+		z = Ops::Sub(z, fz);
+		F u = NoiseFade<Ops>(x);
+		F w = NoiseFade<Ops>(z);
+
+		Ops::Store(out + n, PerlinPlane2D<Ops>(p, Ops::Gather(p, X), Ops::Gather(p, Ops::AddI(X, one)), Y, Z, x, z, u, w));
+
+	}
+
+	return n;
+
+}
+
+// 2D Improved Perlin noise on two integer y planes at once, returns the number of points processed
+// The square, relative position, fade curves and first level of hashing are shared between the planes
+template <class Ops>
+int PerlinNoise2DDualKernel(const int* p, const float* xs, const float* zs, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	const I one = Ops::SetI(1);
+	const I mask = Ops::SetI(255);
+	const I YA = Ops::SetI(planeA & 255);
+	const I YB = Ops::SetI(planeB & 255);
+
+	int n = 0;
+
+	for (; n + Ops::Width <= count; n += Ops::Width)
+	{
+
+		F x = Ops::Load(xs + n);
+		F z = Ops::Load(zs + n);
+
+		F fx = Ops::Floor(x);
+		F fz = Ops::Floor(z);
+		I X = Ops::AndI(Ops::ToInt(fx), mask);
+		I Z = Ops::AndI(Ops::ToInt(fz), mask);
+
+		x = Ops::Sub(x, fx);
+		z = Ops::Sub(z, fz);
+		F u = NoiseFade<Ops>(x);
+		F w = NoiseFade<Ops>(z);
+
+		I pX = Ops::Gather(p, X);
+		I pX1 = Ops::Gather(p, Ops::AddI(X, one));
+
+		Ops::Store(outA + n, PerlinPlane2D<Ops>(p, pX, pX1, YA, Z, x, z, u, w));
+		Ops::Store(outB + n, PerlinPlane2D<Ops>(p, pX, pX1, YB, Z, x, z, u, w));
+
+	}
+
+	return n;
+
+}
+
+// Contribution of a single Simplex corner, max(0, 0.6 - r^2)^4 * dot(grad, d)
+template <class Ops>
+inline typename Ops::F SimplexCorner(const SimplexGradientTable& grad, typename Ops::I gi, typename Ops::F x, typename Ops::F y, typename Ops::F z)
+{
+
+	typedef typename Ops::F F;
+
+	F t = Ops::Sub(Ops::Sub(Ops::Sub(Ops::Set(0.6f), Ops::Mul(x, x)), Ops::Mul(y, y)), Ops::Mul(z, z));
+	t = Ops::Max(t, Ops::Set(0.0f));
+	t = Ops::Mul(t, t);
+
+	F dot = Ops::Add(Ops::Add(Ops::Mul(Ops::GatherF(grad.x, gi), x), Ops::Mul(Ops::GatherF(grad.y, gi), y)), Ops::Mul(Ops::GatherF(grad.z, gi), z));
+
+	return Ops::Mul(Ops::Mul(t, t), dot);
+
+}
+
+// 3D Simplex noise for every full vector of points, returns the number of points processed
+// perm and permMod12 are the doubled 512 entry permutation tables from SimplexNoise
+template <class Ops>
+int SimplexNoise3DKernel(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* xs, const float* ys, const float* zs, float* out, int count)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+	typedef typename Ops::M M;
+
+	const F F3 = Ops::Set(1.0f / 3.0f);
+	const F G3 = Ops::Set(1.0f / 6.0f);
+	const F G3x2 = Ops::Set(2.0f / 6.0f);
+	const F G3x3 = Ops::Set(3.0f / 6.0f);
+	const F fone = Ops::Set(1.0f);
+	const F half = Ops::Set(0.5f);
+	const F three = Ops::Set(3.0f);
+	const I one = Ops::SetI(1);
+	const I mask = Ops::SetI(255);
+
+	int n = 0;
+
+	for (; n + Ops::Width <= count; n += Ops::Width)
+	{
+
+		F xin = Ops::Load(xs + n);
+		F yin = Ops::Load(ys + n);
+		F zin = Ops::Load(zs + n);
+
+		// Skew the input space to determine which simplex cell we're in
+		// This is done on integer and fractional parts separately, so the distances from the cell origin stay accurate
+		// in single precision far away from the origin. With x = X + xf the skewed coordinate x + s is
+		// X + q + (xf + (r + xf + yf + zf) / 3), where q and r are the quotient and remainder of (X + Y + Z) / 3
+		F X = Ops::Floor(xin);
+		F Y = Ops::Floor(yin);
+		F Z = Ops::Floor(zin);
+		F xf = Ops::Sub(xin, X);
+		F yf = Ops::Sub(yin, Y);
+		F zf = Ops::Sub(zin, Z);
+
+		F S = Ops::Add(Ops::Add(X, Y), Z);
+		F q = Ops::Floor(Ops::Mul(Ops::Add(S, half), F3));
+		F r = Ops::Sub(S, Ops::Mul(q, three));
+		F s = Ops::Mul(Ops::Add(Ops::Add(Ops::Add(r, xf), yf), zf), F3);
+
+		F io = Ops::Floor(Ops::Add(xf, s));
+		F jo = Ops::Floor(Ops::Add(yf, s));
+		F ko = Ops::Floor(Ops::Add(zf, s));
+
+		// Unskew the cell origin back to (x,y,z) space and find the distances from it, all of the large terms cancel out
+		F t = Ops::Mul(Ops::Add(Ops::Add(Ops::Add(r, io), jo), ko), G3);
+		F x0 = Ops::Add(Ops::Sub(xf, io), t);
+		F y0 = Ops::Add(Ops::Sub(yf, jo), t);
+		F z0 = Ops::Add(Ops::Sub(zf, ko), t);
+
+		// Determine which simplex we are in, this is the branch table from SimplexNoise::noise written as masks
+		M a = Ops::GreaterEqual(x0, y0);
+		M b = Ops::GreaterEqual(y0, z0);
+		M c = Ops::GreaterEqual(x0, z0);
+		M bc = Ops::And(b, c);
+
+		F i1 = Ops::MaskToOne(Ops::And(a, Ops::Or(b, c)));
+		F j1 = Ops::MaskToOne(Ops::And(Ops::Not(a), b));
+		F k1 = Ops::MaskToOne(Ops::And(Ops::Not(b), Ops::Not(Ops::And(a, c))));
+		F i2 = Ops::MaskToOne(Ops::Or(a, bc));
+		F j2 = Ops::MaskToOne(Ops::Or(Ops::Not(a), b));
+		F k2 = Ops::MaskToOne(Ops::Not(bc));
+
+		// Offsets for the remaining corners in (x,y,z) coords
+		F x1 = Ops::Add(Ops::Sub(x0, i1), G3);
+		F y1 = Ops::Add(Ops::Sub(y0, j1), G3);
+		F z1 = Ops::Add(Ops::Sub(z0, k1), G3);
+		F x2 = Ops::Add(Ops::Sub(x0, i2), G3x2);
+		F y2 = Ops::Add(Ops::Sub(y0, j2), G3x2);
+		F z2 = Ops::Add(Ops::Sub(z0, k2), G3x2);
+		F x3 = Ops::Add(Ops::Sub(x0, fone), G3x3);
+		F y3 = Ops::Add(Ops::Sub(y0, fone), G3x3);
+		F z3 = Ops::Add(Ops::Sub(z0, fone), G3x3);
+
+		// Work out the hashed gradient indices of the four simplex corners
+		I qi = Ops::ToInt(q);
+		I ii = Ops::AndI(Ops::AddI(Ops::AddI(Ops::ToInt(X), qi), Ops::ToInt(io)), mask);
+		I jj = Ops::AndI(Ops::AddI(Ops::AddI(Ops::ToInt(Y), qi), Ops::ToInt(jo)), mask);
+		I kk = Ops::AndI(Ops::AddI(Ops::AddI(Ops::ToInt(Z), qi), Ops::ToInt(ko)), mask);
+
+		I gi0 = Ops::Gather(permMod12, Ops::AddI(ii, Ops::Gather(perm, Ops::AddI(jj, Ops::Gather(perm, kk)))));
+		I gi1 = Ops::Gather(permMod12, Ops::AddI(Ops::AddI(ii, Ops::ToInt(i1)),
+			Ops::Gather(perm, Ops::AddI(Ops::AddI(jj, Ops::ToInt(j1)), Ops::Gather(perm, Ops::AddI(kk, Ops::ToInt(k1)))))));
+		I gi2 = Ops::Gather(permMod12, Ops::AddI(Ops::AddI(ii, Ops::ToInt(i2)),
+			Ops::Gather(perm, Ops::AddI(Ops::AddI(jj, Ops::ToInt(j2)), Ops::Gather(perm, Ops::AddI(kk, Ops::ToInt(k2)))))));
+		I gi3 = Ops::Gather(permMod12, Ops::AddI(Ops::AddI(ii, one),
+			Ops::Gather(perm, Ops::AddI(Ops::AddI(jj, one), Ops::Gather(perm, Ops::AddI(kk, one))))));
+
+		// Add contributions from each corner, scaled to stay just inside [-1,1]
+		F sum = Ops::Add(Ops::Add(Ops::Add(SimplexCorner<Ops>(grad, gi0, x0, y0, z0), SimplexCorner<Ops>(grad, gi1, x1, y1, z1)),
+			SimplexCorner<Ops>(grad, gi2, x2, y2, z2)), SimplexCorner<Ops>(grad, gi3, x3, y3, z3));
+
+		Ops::Store(out + n, Ops::Mul(Ops::Set(32.0f), sum));
+
+	}
+
+	return n;
+
+}
+
+// Falloff of a single 2D Simplex corner, max(0, 0.5 - r^2)^4
+template <class Ops>
+inline typename Ops::F SimplexFalloff2D(typename Ops::F x, typename Ops::F y)
+{
+
+	typedef typename Ops::F F;
+
+	F t = Ops::Sub(Ops::Sub(Ops::Set(0.5f), Ops::Mul(x, x)), Ops::Mul(y, y));
+	t = Ops::Max(t, Ops::Set(0.0f));
+	t = Ops::Mul(t, t);
+
+	return Ops::Mul(t, t);
+
+}
+
+template <class Ops>
+inline typename Ops::F SimplexDot2D(const SimplexGradientTable& grad, typename Ops::I gi, typename Ops::F x, typename Ops::F y)
+{
+
+	return Ops::Add(Ops::Mul(Ops::GatherF(grad.x, gi), x), Ops::Mul(Ops::GatherF(grad.y, gi), y));
+
+}
+
+// Cell and corner offsets of a 2D Simplex sample, shared by the single and dual plane kernels
+template <class Ops>
+struct SimplexCell2D
+{
+
+	typename Ops::F x0, y0, x1, y1, x2, y2;		// Offsets from the three corners
+	typename Ops::I ii, jj, ii1, jj1;				// Wrapped lattice coordinates of the first and middle corners
+
+};
+
+template <class Ops>
+inline void SimplexLocate2D(typename Ops::F xin, typename Ops::F yin, SimplexCell2D<Ops>& cell)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+	typedef typename Ops::M M;
+
+	const F F2 = Ops::Set(0.366025403784f);
+	const F F2a = Ops::Set(46.0f / 128.0f);
+	const F F2b = Ops::Set(109.0f / 16384.0f);
+	const F F2c = Ops::Set(-2.4282468114034117e-6f);
+	const F G2 = Ops::Set(0.211324865405f);
+	const F G2x2 = Ops::Set(0.42264973081f);
+	const F oneMinusG2x2 = Ops::Set(1.0f - 0.42264973081f);
+	const F fone = Ops::Set(1.0f);
+	const I mask = Ops::SetI(255);
+
+	// Skew the input space to determine which simplex cell we're in
+	// As in the 3D kernel the integer and fractional parts are kept apart to stay accurate away from the origin.
+	// With x = X + xf the skewed coordinate x + s is X + Pi + (xf + Pf + (xf + yf) * F2), where Pi and Pf are the integer
+	// and fractional parts of P = (X + Y) * F2. F2 is split into a + b + c, with a and b short enough that (X + Y) * a
+	// and (X + Y) * b are exact for |X + Y| < 131072, which leaves only the small (X + Y) * c term to round
+	F X = Ops::Floor(xin);
+	F Y = Ops::Floor(yin);
+	F xf = Ops::Sub(xin, X);
+	F yf = Ops::Sub(yin, Y);
+
+	F S = Ops::Add(X, Y);
+	F Pa = Ops::Mul(S, F2a);
+	F Pb = Ops::Mul(S, F2b);
+	F Pai = Ops::Floor(Pa);
+	F Pbi = Ops::Floor(Pb);
+	F Pi = Ops::Add(Pai, Pbi);
+	F Pf = Ops::Add(Ops::Add(Ops::Sub(Pa, Pai), Ops::Sub(Pb, Pbi)), Ops::Mul(S, F2c));
+	F s = Ops::Add(Pf, Ops::Mul(Ops::Add(xf, yf), F2));
+
+	F io = Ops::Floor(Ops::Add(xf, s));
+	F jo = Ops::Floor(Ops::Add(yf, s));
+
+	// Unskew the cell origin back to (x,y) space and find the distances from it, all of the large terms cancel out
+	F t = Ops::Add(Ops::Mul(Pf, oneMinusG2x2), Ops::Mul(Ops::Add(io, jo), G2));
+	cell.x0 = Ops::Add(Ops::Sub(xf, io), t);
+	cell.y0 = Ops::Add(Ops::Sub(yf, jo), t);
+
+	// Lower triangle, XY order: (0,0)->(1,0)->(1,1), upper triangle, YX order: (0,0)->(0,1)->(1,1)
+	M lower = Ops::Not(Ops::GreaterEqual(cell.y0, cell.x0));
+	F i1 = Ops::MaskToOne(lower);
+	F j1 = Ops::Sub(fone, i1);
+
+	cell.x1 = Ops::Add(Ops::Sub(cell.x0, i1), G2);
+	cell.y1 = Ops::Add(Ops::Sub(cell.y0, j1), G2);
+	cell.x2 = Ops::Add(Ops::Sub(cell.x0, fone), G2x2);
+	cell.y2 = Ops::Add(Ops::Sub(cell.y0, fone), G2x2);
+
+	I Pii = Ops::ToInt(Pi);
+	cell.ii = Ops::AndI(Ops::AddI(Ops::AddI(Ops::ToInt(X), Pii), Ops::ToInt(io)), mask);
+	cell.jj = Ops::AndI(Ops::AddI(Ops::AddI(Ops::ToInt(Y), Pii), Ops::ToInt(jo)), mask);
+	cell.ii1 = Ops::AddI(cell.ii, Ops::ToInt(i1));
+	cell.jj1 = Ops::AddI(cell.jj, Ops::ToInt(j1));
+
+}
+
+// Sum of the gradient dot products of the three corners on one plane, weighted by the corner falloffs
+template <class Ops>
+inline typename Ops::F SimplexPlane2D(const int* perm, const int* permMod12, const SimplexGradientTable& grad, const SimplexCell2D<Ops>& cell,
+	typename Ops::I planeHash, typename Ops::F n0, typename Ops::F n1, typename Ops::F n2)
+{
+
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	const I one = Ops::SetI(1);
+
+	// Work out the hashed gradient indices of the three simplex corners
+	I gi0 = Ops::Gather(permMod12, Ops::AddI(cell.ii, Ops::Gather(perm, Ops::AddI(cell.jj, planeHash))));
+	I gi1 = Ops::Gather(permMod12, Ops::AddI(cell.ii1, Ops::Gather(perm, Ops::AddI(cell.jj1, planeHash))));
+	I gi2 = Ops::Gather(permMod12, Ops::AddI(Ops::AddI(cell.ii, one), Ops::Gather(perm, Ops::AddI(Ops::AddI(cell.jj, one), planeHash))));
+
+	F sum = Ops::Add(Ops::Add(Ops::Mul(n0, SimplexDot2D<Ops>(grad, gi0, cell.x0, cell.y0)), Ops::Mul(n1, SimplexDot2D<Ops>(grad, gi1, cell.x1, cell.y1))),
+		Ops::Mul(n2, SimplexDot2D<Ops>(grad, gi2, cell.x2, cell.y2)));
+
+	// Scale to return values in the interval [-1,1]
+	return Ops::Mul(Ops::Set(70.0f), sum);
+
+}
+
+// 2D Simplex noise, returns the number of points processed
+// plane selects an independent layer of noise by feeding an extra level into the permutation hash
+template <class Ops>
+int SimplexNoise2DKernel(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* xs, const float* ys, int plane, float* out, int count)
+{
+
+	const typename Ops::I planeHash = Ops::SetI(perm[plane & 255]);
+
+	int n = 0;
+
+	for (; n + Ops::Width <= count; n += Ops::Width)
+	{
+
+		SimplexCell2D<Ops> cell;
+		SimplexLocate2D<Ops>(Ops::Load(xs + n), Ops::Load(ys + n), cell);
+
+		Ops::Store(out + n, SimplexPlane2D<Ops>(perm, permMod12, grad, cell, planeHash,
+			SimplexFalloff2D<Ops>(cell.x0, cell.y0), SimplexFalloff2D<Ops>(cell.x1, cell.y1), SimplexFalloff2D<Ops>(cell.x2, cell.y2)));
+
+	}
+
+	return n;
+
+}
+
+// 2D Simplex noise on two planes at once, returns the number of points processed
+// Everything except the gradient lookups is shared between the planes, including the corner falloffs
+template <class Ops>
+int SimplexNoise2DDualKernel(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* xs, const float* ys, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	typedef typename Ops::F F;
+
+	const typename Ops::I planeHashA = Ops::SetI(perm[planeA & 255]);
+	const typename Ops::I planeHashB = Ops::SetI(perm[planeB & 255]);
+
+	int n = 0;
+
+	for (; n + Ops::Width <= count; n += Ops::Width)
+	{
+
+		SimplexCell2D<Ops> cell;
+		SimplexLocate2D<Ops>(Ops::Load(xs + n), Ops::Load(ys + n), cell);
+
+		F n0 = SimplexFalloff2D<Ops>(cell.x0, cell.y0);
+		F n1 = SimplexFalloff2D<Ops>(cell.x1, cell.y1);
+		F n2 = SimplexFalloff2D<Ops>(cell.x2, cell.y2);
+
+		Ops::Store(outA + n, SimplexPlane2D<Ops>(perm, permMod12, grad, cell, planeHashA, n0, n1, n2));
+		Ops::Store(outB + n, SimplexPlane2D<Ops>(perm, permMod12, grad, cell, planeHashB, n0, n1, n2));
+
+	}
+
+	return n;
+
+}
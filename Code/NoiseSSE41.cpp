@@ -0,0 +1,131 @@
+// NoiseSSE41.cpp
+// SSE4.1 instantiation of the batched noise kernels, four points per iteration
+// The whole translation unit is compiled for SSE4.1 and is only ever called after NoiseBatch.cpp has checked the CPU supports it
+
+#include "NoiseBatch.h"
+
+#if defined(NOISE_BATCH_X86)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+
+#include <smmintrin.h>
+#include "NoiseKernels.h"
+
+struct SSE41Ops
+{
+
+	typedef __m128 F;
+	typedef __m128i I;
+	typedef __m128 M;
+
+	static const int Width = 4;
+
+	static F Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, F a) { _mm_storeu_ps(p, a); }
+	static F Set(float a) { return _mm_set1_ps(a); }
+	static I SetI(int a) { return _mm_set1_epi32(a); }
+
+	static F Add(F a, F b) { return _mm_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static F Max(F a, F b) { return _mm_max_ps(a, b); }
+	static F Floor(F a) { return _mm_floor_ps(a); }
+	static I ToInt(F a) { return _mm_cvttps_epi32(a); }
+
+	static I AddI(I a, I b) { return _mm_add_epi32(a, b); }
+	static I AndI(I a, I b) { return _mm_and_si128(a, b); }
+
+	// SSE4.1 has no gather instruction, so look each lane up individually
+	static I Gather(const int* table, I index)
+	{
+
+		return _mm_setr_epi32(table[_mm_cvtsi128_si32(index)], table[_mm_extract_epi32(index, 1)],
+			table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 3)]);
+
+	}
+
+	static F GatherF(const float* table, I index)
+	{
+
+		return _mm_setr_ps(table[_mm_cvtsi128_si32(index)], table[_mm_extract_epi32(index, 1)],
+			table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 3)]);
+
+	}
+
+	static M LessI(I a, I b) { return _mm_castsi128_ps(_mm_cmplt_epi32(a, b)); }
+	static M EqualI(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+	static M GreaterEqual(F a, F b) { return _mm_cmpge_ps(a, b); }
+	static M And(M a, M b) { return _mm_and_ps(a, b); }
+	static M Or(M a, M b) { return _mm_or_ps(a, b); }
+	static M Not(M a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	static F Select(M mask, F a, F b) { return _mm_blendv_ps(b, a, mask); }
+	static F MaskToOne(M mask) { return _mm_and_ps(mask, _mm_set1_ps(1.0f)); }
+
+	// Negate the lanes where bit is non-zero
+	static F FlipSign(F a, I bit)
+	{
+
+		I sign = _mm_andnot_si128(_mm_cmpeq_epi32(bit, _mm_setzero_si128()), _mm_set1_epi32((int)0x80000000));
+		return _mm_xor_ps(a, _mm_castsi128_ps(sign));
+
+	}
+
+};
+
+int PerlinNoise3DSSE41(const int* p, const float* x, const float* y, const float* z, float* out, int count)
+{
+
+	return PerlinNoise3DKernel<SSE41Ops>(p, x, y, z, out, count);
+
+}
+
+int SimplexNoise3DSSE41(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, const float* z, float* out, int count)
+{
+
+	return SimplexNoise3DKernel<SSE41Ops>(perm, permMod12, grad, x, y, z, out, count);
+
+}
+
+int PerlinNoise2DSSE41(const int* p, const float* x, const float* z, int plane, float* out, int count)
+{
+
+	return PerlinNoise2DKernel<SSE41Ops>(p, x, z, plane, out, count);
+
+}
+
+int SimplexNoise2DSSE41(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, int plane, float* out, int count)
+{
+
+	return SimplexNoise2DKernel<SSE41Ops>(perm, permMod12, grad, x, y, plane, out, count);
+
+}
+
+int PerlinNoise2DDualSSE41(const int* p, const float* x, const float* z, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	return PerlinNoise2DDualKernel<SSE41Ops>(p, x, z, planeA, planeB, outA, outB, count);
+
+}
+
+int SimplexNoise2DDualSSE41(const int* perm, const int* permMod12, const SimplexGradientTable& grad,
+	const float* x, const float* y, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	return SimplexNoise2DDualKernel<SSE41Ops>(perm, permMod12, grad, x, y, planeA, planeB, outA, outB, count);
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -1,49 +1,145 @@
 #include "SimplexNoise.h"
+#include "NoiseBatch.h"
 
 
-SimplexNoise::SimplexNoise()
+template <typename T>
+SimplexNoiseT<T>::SimplexNoiseT()
 {
 
 	for (int i = 0; i<512; i++)
 	{
 
 		perm[i] = p[i & 255];
-		permMod12[i] = (short)(perm[i] % 12);
+		permMod12[i] = perm[i] % 12;
 
 	}
 
 }
 
-int SimplexNoise::fastfloor(double x) {
+template <typename T>
+int SimplexNoiseT<T>::fastfloor(T x) {
 
 	int xi = (int)x;
 	return x<xi ? xi - 1 : xi;
 
 }
 
-double SimplexNoise::dot(Grad g, double x, double y, double z) {
+template <typename T>
+T SimplexNoiseT<T>::dot(const Grad& g, T x, T y) {
+
+	return g.x*x + g.y*y;
+
+}
+
+template <typename T>
+T SimplexNoiseT<T>::dot(const Grad& g, T x, T y, T z) {
 
 	return g.x*x + g.y*y + g.z*z;
 
 }
 
+template <typename T>
+void SimplexNoiseT<T>::skew(T xin, T yin, int& i, int& j, T& x0, T& y0) {
+
+	T s = (xin + yin)*F2;									// Hairy factor for 2D
+	i = fastfloor(xin + s);
+	j = fastfloor(yin + s);
+
+	T t = (i + j)*G2;
+	x0 = xin - (i - t);										// Unskew the cell origin back to (x,y) space
+	y0 = yin - (j - t);
+
+}
+
+template <typename T>
+void SimplexNoiseT<T>::skew(T xin, T yin, T zin, int& i, int& j, int& k, T& x0, T& y0, T& z0) {
+
+	T s = (xin + yin + zin)*F3;								// Very nice and simple skew factor for 3D
+	i = fastfloor(xin + s);
+	j = fastfloor(yin + s);
+	k = fastfloor(zin + s);
+
+	T t = (i + j + k)*G3;
+	x0 = xin - (i - t);										// Unskew the cell origin back to (x,y,z) space
+	y0 = yin - (j - t);
+	z0 = zin - (k - t);
+
+}
+
+// Single precision runs out of bits for the cell distances once the skewed coordinates get large,
+// so the float versions skew the integer and fractional parts separately, the same way as the batched kernels (see NoiseKernels.h)
+template <>
+void SimplexNoiseT<float>::skew(float xin, float yin, int& i, int& j, float& x0, float& y0) {
+
+	float X = floorf(xin);
+	float Y = floorf(yin);
+	float xf = xin - X;
+	float yf = yin - Y;
+
+	// F2 split into a + b + c, (X + Y) * a and (X + Y) * b are exact
+	float S = X + Y;
+	float Pa = S * (46.0f / 128.0f);
+	float Pb = S * (109.0f / 16384.0f);
+	float Pai = floorf(Pa);
+	float Pbi = floorf(Pb);
+	float Pf = (Pa - Pai) + (Pb - Pbi) + S * -2.4282468114034117e-6f;
+	float s = Pf + (xf + yf) * F2;
+
+	float io = floorf(xf + s);
+	float jo = floorf(yf + s);
+
+	float t = Pf * (1.0f - 2.0f * G2) + (io + jo) * G2;
+	x0 = xf - io + t;
+	y0 = yf - jo + t;
+
+	int Pi = (int)(Pai + Pbi);
+	i = (int)X + Pi + (int)io;
+	j = (int)Y + Pi + (int)jo;
+
+}
+
+template <>
+void SimplexNoiseT<float>::skew(float xin, float yin, float zin, int& i, int& j, int& k, float& x0, float& y0, float& z0) {
+
+	float X = floorf(xin);
+	float Y = floorf(yin);
+	float Z = floorf(zin);
+	float xf = xin - X;
+	float yf = yin - Y;
+	float zf = zin - Z;
+
+	// q and r are the quotient and remainder of (X + Y + Z) / 3
+	float S = X + Y + Z;
+	float q = floorf((S + 0.5f) * F3);
+	float r = S - q * 3.0f;
+	float s = (r + xf + yf + zf) * F3;
+
+	float io = floorf(xf + s);
+	float jo = floorf(yf + s);
+	float ko = floorf(zf + s);
+
+	float t = (r + io + jo + ko) * G3;
+	x0 = xf - io + t;
+	y0 = yf - jo + t;
+	z0 = zf - ko + t;
+
+	int qi = (int)q;
+	i = (int)X + qi + (int)io;
+	j = (int)Y + qi + (int)jo;
+	k = (int)Z + qi + (int)ko;
+
+}
+
 // 3D simplex noise
-double SimplexNoise::noise(double xin, double yin, double zin) {
-
-	double n0, n1, n2, n3;									// Noise contributions from the four corners
-															// Skew the input space to determine which simplex cell we're in
-	double s = (xin + yin + zin)*F3;						// Very nice and simple skew factor for 3D
-	int i = fastfloor(xin + s);
-	int j = fastfloor(yin + s);
-	int k = fastfloor(zin + s);
-
-	double t = (i + j + k)*G3;
-	double X0 = i - t;										// Unskew the cell origin back to (x,y,z) space
-	double Y0 = j - t;
-	double Z0 = k - t;
-	double x0 = xin - X0;									// The x,y,z distances from the cell origin
-	double y0 = yin - Y0;
-	double z0 = zin - Z0;
+template <typename T>
+T SimplexNoiseT<T>::noise(T xin, T yin, T zin) {
+
+	T n0, n1, n2, n3;										// Noise contributions from the four corners
+
+	// Skew the input space to determine which simplex cell we're in
+	int i, j, k;											// Cell origin in (i,j,k) coords
+	T x0, y0, z0;											// The x,y,z distances from the cell origin
+	skew(xin, yin, zin, i, j, k, x0, y0, z0);
 
 	// For the 3D case, the simplex shape is a slightly irregular tetrahedron.
 	// Determine which simplex we are in.
@@ -94,17 +190,17 @@ double SimplexNoise::noise(double xin, double yin, double zin) {
 	// a step of (0,1,0) in (i,j,k) means a step of (-c,1-c,-c) in (x,y,z), and
 	// a step of (0,0,1) in (i,j,k) means a step of (-c,-c,1-c) in (x,y,z), where
 	// c = 1/6.
-	double x1 = x0 - i1 + G3;								// Offsets for second corner in (x,y,z) coords
-	double y1 = y0 - j1 + G3;
-	double z1 = z0 - k1 + G3;
+	T x1 = x0 - i1 + G3;									// Offsets for second corner in (x,y,z) coords
+	T y1 = y0 - j1 + G3;
+	T z1 = z0 - k1 + G3;
 
-	double x2 = x0 - i2 + 2.0f*G3;							// Offsets for third corner in (x,y,z) coords
-	double y2 = y0 - j2 + 2.0f*G3;
-	double z2 = z0 - k2 + 2.0f*G3;
+	T x2 = x0 - i2 + T(2)*G3;								// Offsets for third corner in (x,y,z) coords
+	T y2 = y0 - j2 + T(2)*G3;
+	T z2 = z0 - k2 + T(2)*G3;
 
-	double x3 = x0 - 1.0f + 3.0f*G3;						// Offsets for last corner in (x,y,z) coords
-	double y3 = y0 - 1.0f + 3.0f*G3;
-	double z3 = z0 - 1.0f + 3.0f*G3;
+	T x3 = x0 - T(1) + T(3)*G3;							// Offsets for last corner in (x,y,z) coords
+	T y3 = y0 - T(1) + T(3)*G3;
+	T z3 = z0 - T(1) + T(3)*G3;
 
 	// Work out the hashed gradient indices of the four simplex corners
 	int ii = i & 255;
@@ -116,12 +212,12 @@ double SimplexNoise::noise(double xin, double yin, double zin) {
 	int gi3 = permMod12[ii + 1 + perm[jj + 1 + perm[kk + 1]]];
 
 	// Calculate the contribution from the four corners
-	double t0 = 0.6f - x0*x0 - y0*y0 - z0*z0;
+	T t0 = T(0.6f) - x0*x0 - y0*y0 - z0*z0;
 
-	if (t0 < 0.0f)
+	if (t0 < T(0))
 	{
 
-		n0 = 0.0f;
+		n0 = T(0);
 
 	}
 	else {
@@ -131,12 +227,12 @@ double SimplexNoise::noise(double xin, double yin, double zin) {
 
 	}
 
-	double t1 = 0.6f - x1*x1 - y1*y1 - z1*z1;
+	T t1 = T(0.6f) - x1*x1 - y1*y1 - z1*z1;
 
-	if (t1 < 0.0f)
+	if (t1 < T(0))
 	{
 
-		n1 = 0.0f;
+		n1 = T(0);
 
 	}
 	else {
@@ -146,11 +242,11 @@ double SimplexNoise::noise(double xin, double yin, double zin) {
 
 	}
 
-	double t2 = 0.6f - x2*x2 - y2*y2 - z2*z2;
+	T t2 = T(0.6f) - x2*x2 - y2*y2 - z2*z2;
 
-	if (t2 < 0.0f) {
+	if (t2 < T(0)) {
 
-		n2 = 0.0f;
+		n2 = T(0);
 
 	}
 	else {
@@ -160,12 +256,12 @@ double SimplexNoise::noise(double xin, double yin, double zin) {
 
 	}
 
-	double t3 = 0.6f - x3*x3 - y3*y3 - z3*z3;
+	T t3 = T(0.6f) - x3*x3 - y3*y3 - z3*z3;
 
-	if (t3 < 0.0f)
+	if (t3 < T(0))
 	{
 
-		n3 = 0.0f;
+		n3 = T(0);
 
 	}
 	else {
@@ -177,5 +273,178 @@ double SimplexNoise::noise(double xin, double yin, double zin) {
 
 	// Add contributions from each corner to get the final noise value.
 	// The result is scaled to stay just inside [-1,1]
-	return 32.0*(n0 + n1 + n2 + n3);
-}
\ No newline at end of file
+	return T(32)*(n0 + n1 + n2 + n3);
+}
+
+// Batched 3D simplex noise
+template <typename T>
+void SimplexNoiseT<T>::noise(const float* xin, const float* yin, const float* zin, float* out, int count)
+{
+
+	BatchSimplexNoise3D(perm, permMod12, xin, yin, zin, out, count);
+
+}
+
+// 2D simplex noise
+template <typename T>
+T SimplexNoiseT<T>::noise2D(T xin, T yin, int plane) {
+
+	T n0, n1, n2;											// Noise contributions from the three corners
+
+	// Skew the input space to determine which simplex cell we're in
+	int i, j;												// Cell origin in (i,j) coords
+	T x0, y0;												// The x,y distances from the cell origin
+	skew(xin, yin, i, j, x0, y0);
+
+	// For the 2D case, the simplex shape is an equilateral triangle.
+	// Determine which simplex we are in.
+	int i1, j1;												// Offsets for second (middle) corner of simplex in (i,j) coords
+
+	if (x0 > y0)
+	{
+
+		i1 = 1; j1 = 0;
+
+	} // lower triangle, XY order: (0,0)->(1,0)->(1,1)
+	else {
+
+		i1 = 0; j1 = 1;
+
+	} // upper triangle, YX order: (0,0)->(0,1)->(1,1)
+
+	// A step of (1,0) in (i,j) means a step of (1-c,-c) in (x,y), and
+	// a step of (0,1) in (i,j) means a step of (-c,1-c) in (x,y), where
+	// c = (3-sqrt(3))/6
+	T x1 = x0 - i1 + G2;									// Offsets for middle corner in (x,y) unskewed coords
+	T y1 = y0 - j1 + G2;
+	T x2 = x0 - T(1) + T(2) * G2;							// Offsets for last corner in (x,y) unskewed coords
+	T y2 = y0 - T(1) + T(2) * G2;
+
+	// Work out the hashed gradient indices of the three simplex corners
+	// The plane is hashed in as a third lattice coordinate so each plane gives independent noise
+	int ii = i & 255;
+	int jj = j & 255;
+	int pp = perm[plane & 255];
+	int gi0 = permMod12[ii + perm[jj + pp]];
+	int gi1 = permMod12[ii + i1 + perm[jj + j1 + pp]];
+	int gi2 = permMod12[ii + 1 + perm[jj + 1 + pp]];
+
+	// Calculate the contribution from the three corners
+	T t0 = T(0.5) - x0*x0 - y0*y0;
+
+	if (t0 < T(0))
+	{
+
+		n0 = T(0);
+
+	}
+	else {
+
+		t0 *= t0;
+		n0 = t0 * t0 * dot(grad3[gi0], x0, y0);				// (x,y) of grad3 used for 2D gradient
+
+	}
+
+	T t1 = T(0.5) - x1*x1 - y1*y1;
+
+	if (t1 < T(0))
+	{
+
+		n1 = T(0);
+
+	}
+	else {
+
+		t1 *= t1;
+		n1 = t1 * t1 * dot(grad3[gi1], x1, y1);
+
+	}
+
+	T t2 = T(0.5) - x2*x2 - y2*y2;
+
+	if (t2 < T(0))
+	{
+
+		n2 = T(0);
+
+	}
+	else {
+
+		t2 *= t2;
+		n2 = t2 * t2 * dot(grad3[gi2], x2, y2);
+
+	}
+
+	// Add contributions from each corner to get the final noise value.
+	// The result is scaled to return values in the interval [-1,1].
+	return T(70) * (n0 + n1 + n2);
+
+}
+
+// Batched 2D simplex noise
+template <typename T>
+void SimplexNoiseT<T>::noise2D(const float* xin, const float* yin, int plane, float* out, int count)
+{
+
+	BatchSimplexNoise2D(perm, permMod12, xin, yin, plane, out, count);
+
+}
+
+// 2D simplex noise on two planes
+template <typename T>
+void SimplexNoiseT<T>::noise2DDual(T xin, T yin, int planeA, int planeB, T& outA, T& outB) {
+
+	// Skew the input space to determine which simplex cell we're in
+	int i, j;
+	T x0, y0;												// The x,y distances from the cell origin
+	skew(xin, yin, i, j, x0, y0);
+
+	int i1 = x0 > y0 ? 1 : 0;								// Offsets for the middle corner in (i,j) coords
+	int j1 = 1 - i1;
+
+	T x1 = x0 - i1 + G2;									// Offsets for middle corner in (x,y) unskewed coords
+	T y1 = y0 - j1 + G2;
+	T x2 = x0 - T(1) + T(2) * G2;							// Offsets for last corner in (x,y) unskewed coords
+	T y2 = y0 - T(1) + T(2) * G2;
+
+	// The falloff from each corner doesn't depend on the plane, so work it out once
+	// Squared twice as noise2D does it, so the results match it bit for bit
+	T t0 = T(0.5) - x0*x0 - y0*y0;
+	T t1 = T(0.5) - x1*x1 - y1*y1;
+	T t2 = T(0.5) - x2*x2 - y2*y2;
+	t0 = t0 < T(0) ? T(0) : (t0 * t0) * (t0 * t0);
+	t1 = t1 < T(0) ? T(0) : (t1 * t1) * (t1 * t1);
+	t2 = t2 < T(0) ? T(0) : (t2 * t2) * (t2 * t2);
+
+	int ii = i & 255;
+	int jj = j & 255;
+
+	// First plane
+	int pp = perm[planeA & 255];
+	int gi0 = permMod12[ii + perm[jj + pp]];
+	int gi1 = permMod12[ii + i1 + perm[jj + j1 + pp]];
+	int gi2 = permMod12[ii + 1 + perm[jj + 1 + pp]];
+
+	outA = T(70) * (t0 * dot(grad3[gi0], x0, y0) + t1 * dot(grad3[gi1], x1, y1) + t2 * dot(grad3[gi2], x2, y2));
+
+	// Second plane
+	pp = perm[planeB & 255];
+	gi0 = permMod12[ii + perm[jj + pp]];
+	gi1 = permMod12[ii + i1 + perm[jj + j1 + pp]];
+	gi2 = permMod12[ii + 1 + perm[jj + 1 + pp]];
+
+	outB = T(70) * (t0 * dot(grad3[gi0], x0, y0) + t1 * dot(grad3[gi1], x1, y1) + t2 * dot(grad3[gi2], x2, y2));
+
+}
+
+// Batched 2D simplex noise on two planes
+template <typename T>
+void SimplexNoiseT<T>::noise2DDual(const float* xin, const float* yin, int planeA, int planeB, float* outA, float* outB, int count)
+{
+
+	BatchSimplexNoise2DDual(perm, permMod12, xin, yin, planeA, planeB, outA, outB, count);
+
+}
+
+template class SimplexNoiseT<double>;
+template class SimplexNoiseT<float>;
\ No newline at end of file
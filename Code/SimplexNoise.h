@@ -2,43 +2,35 @@
 // Adapted from Java implementation created by Stefan Gustavson and adapted by Peter Eastman
 // Performs 3D Simplex noise function and returns deterministic noise for a single point
 // Reference found here: http://weber.itn.liu.se/~stegu/simplexnoise/SimplexNoise.java
+// Templated on the scalar type, SimplexNoiseF works entirely in single precision for float-only pipelines
 #pragma once
 #include <cmath>
 
-// Simple data class for gradients
-class Grad
+// Simple data class for gradients, just the three components so a float table packs into 144 bytes
+template <typename T>
+struct GradT
 {
 
-	friend class SimplexNoise;
-
-protected:
-
-	double x, y, z, w;
-
-	Grad(double X, double Y, double Z)
-	{
-
-		x = X;
-		y = Y;
-		z = Z;
-
-	}
+	T x, y, z;
 
 };
 
-class SimplexNoise 
+template <typename T>
+class SimplexNoiseT 
 {  // Simplex noise in 2D, 3D and 4D
 
 public:
 
-	SimplexNoise();
+	SimplexNoiseT();
 
 private:
 
+	typedef GradT<T> Grad;
+
 	Grad grad3[12] = { 
-		Grad(1,1,0), Grad(-1,1,0), Grad(1,-1,0), Grad(-1,-1,0),
-		 Grad(1,0,1), Grad(-1,0,1), Grad(1,0,-1), Grad(-1,0,-1),
-		 Grad(0,1,1), Grad(0,-1,1), Grad(0,1,-1), Grad(0,-1,-1) 
+		{ 1,1,0 }, { -1,1,0 }, { 1,-1,0 }, { -1,-1,0 },
+		 { 1,0,1 }, { -1,0,1 }, { 1,0,-1 }, { -1,0,-1 },
+		 { 0,1,1 }, { 0,-1,1 }, { 0,1,-1 }, { 0,-1,-1 } 
 	};
 
 	short p[256] = { 151,160,137,91,90,15,
@@ -57,19 +49,43 @@ private:
 	};
 
 	// To remove the need for index wrapping, double the permutation table length
-	short perm[512];
-	short permMod12[512];
+	// Stored as ints so the batched kernels can gather from them directly
+	int perm[512];
+	int permMod12[512];
 
 	// Skewing and unskewing factors for 2, 3, and 4 dimensions
-	double F3 = 1.0 / 3.0;
-	double G3 = 1.0 / 6.0;
+	T F2 = T(0.5 * (sqrt(3.0) - 1.0));
+	T G2 = T((3.0 - sqrt(3.0)) / 6.0);
+	T F3 = T(1.0 / 3.0);
+	T G3 = T(1.0 / 6.0);
 
-	int fastfloor(double x);
-	double dot(Grad g, double x, double y, double z);
+	int fastfloor(T x);
+
+	// Finds the simplex cell containing a point and the distances from its origin
+	void skew(T xin, T yin, int& i, int& j, T& x0, T& y0);
+	void skew(T xin, T yin, T zin, int& i, int& j, int& k, T& x0, T& y0, T& z0);
+	T dot(const Grad& g, T x, T y);
+	T dot(const Grad& g, T x, T y, T z);
 
 public:
 
 	// 3D simplex noise
-	double noise(double xin, double yin, double zin);
+	T noise(T xin, T yin, T zin);
+
+	// Batched 3D simplex noise for a row of points, evaluated in single precision using SIMD where available (see NoiseBatch.h)
+	void noise(const float* xin, const float* yin, const float* zin, float* out, int count);
+
+	// 2D simplex noise, plane selects an independent layer of noise
+	T noise2D(T xin, T yin, int plane = 0);
+	void noise2D(const float* xin, const float* yin, int plane, float* out, int count);
+
+	// 2D simplex noise on two planes at once, everything except the gradient lookups is shared between them
+	void noise2DDual(T xin, T yin, int planeA, int planeB, T& outA, T& outB);
+	void noise2DDual(const float* xin, const float* yin, int planeA, int planeB, float* outA, float* outB, int count);
+
+};
 
-};
\ No newline at end of file
+// The double precision generator is the reference, the float one agrees with it to the same tolerances as the batched kernels (see NoiseBatch.h)
+// Tests/NoiseTests.cpp holds it to 2.5e-6 for coordinates up to 65536 in magnitude, away from the 3D simplex seams
+typedef SimplexNoiseT<double> SimplexNoise;
+typedef SimplexNoiseT<float> SimplexNoiseF;
\ No newline at end of file
@@ -0,0 +1,441 @@
+#include "TerrainAdaptiveMesh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+TerrainAdaptiveMesh::TerrainAdaptiveMesh()
+	: errors(0), errorSize(0), resolution(0), heights(0), stride(0), vertexMap(0), vertices(0), indices(0), vertexCount(0),
+	indexCount(0)
+{
+
+	stats.vertices = 0;
+	stats.triangles = 0;
+	stats.gridTriangles = 0;
+	stats.errorBound = 0.0f;
+	stats.maxError = 0.0f;
+
+}
+
+TerrainAdaptiveMesh::~TerrainAdaptiveMesh()
+{
+
+	delete[] errors;
+	delete[] vertexMap;
+	delete[] vertices;
+	delete[] indices;
+
+}
+
+void TerrainAdaptiveMesh::BuildErrors(const HeightField& field)
+{
+
+	resolution = field.GetResolution();
+
+	// The smallest square of 2^n quads the grid fits in
+	int tileSize = 1;
+
+	while (tileSize < resolution - 1)
+	{
+
+		tileSize *= 2;
+
+	}
+
+	if (errorSize != tileSize + 1)
+	{
+
+		delete[] errors;
+		errorSize = tileSize + 1;
+		errors = new float[errorSize * errorSize];
+
+	}
+
+	std::fill(errors, errors + (errorSize * errorSize), 0.0f);
+
+	delete[] vertexMap;
+	vertexMap = new int[resolution * resolution];
+
+	const float* fieldHeights = field.GetHeights();
+	int fieldStride = field.GetStride();
+
+	// From the smallest triangles up, so every diamond's children are done before it. Each size of square 2s quads across
+	// has the diamonds whose hypotenuses are its sides, then the coarser ones whose hypotenuses are its diagonals
+	for (int s = 1; s < tileSize; s *= 2)
+	{
+
+		for (int y = 0; y <= tileSize; y += s)
+		{
+
+			// Rows on the squares' sides have hypotenuses running along them, the rows halfway up have them running up
+			if ((y / s) % 2 == 0)
+			{
+
+				for (int x = s; x < tileSize; x += 2 * s)
+				{
+
+					DiamondError(fieldHeights, fieldStride, x, y, s, 0, 0, s);
+
+				}
+
+			}
+			else
+			{
+
+				for (int x = 0; x <= tileSize; x += 2 * s)
+				{
+
+					DiamondError(fieldHeights, fieldStride, x, y, 0, s, s, 0);
+
+				}
+
+			}
+
+		}
+
+		// The diagonals alternate direction from square to square, the same way the quilt's do
+		for (int y = s; y < tileSize; y += 2 * s)
+		{
+
+			for (int x = s; x < tileSize; x += 2 * s)
+			{
+
+				if (((x / (2 * s)) + (y / (2 * s))) % 2 == 0)
+				{
+
+					DiamondError(fieldHeights, fieldStride, x, y, s, s, s, -s);
+
+				}
+				else
+				{
+
+					DiamondError(fieldHeights, fieldStride, x, y, s, -s, s, s);
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+void TerrainAdaptiveMesh::DiamondError(const float* fieldHeights, int fieldStride, int x, int y, int rx, int ry, int px, int py)
+{
+
+	int tileSize = errorSize - 1;
+	int last = resolution - 1;
+
+	int ax = x - rx;
+	int ay = y - ry;
+	int bx = x + rx;
+	int by = y + ry;
+
+	// The smallest triangles' children are the grid's own, with no grid points between their corners
+	bool hasChildren = (rx != 0 && ry != 0) || std::abs(rx + ry) > 1;
+
+	float error = 0.0f;
+
+	for (int side = -1; side <= 1; side += 2)
+	{
+
+		int cx = x + (side * px);
+		int cy = y + (side * py);
+
+		// Diamonds on the sides of the square only have one triangle
+		if (cx < 0 || cy < 0 || cx > tileSize || cy > tileSize)
+		{
+
+			continue;
+
+		}
+
+		// Triangles wholly past the last row or column aren't part of the mesh, those reaching past them always get split
+		if (std::min(ax, std::min(bx, cx)) >= last || std::min(ay, std::min(by, cy)) >= last)
+		{
+
+			continue;
+
+		}
+
+		if (std::max(ax, std::max(bx, cx)) > last || std::max(ay, std::max(by, cy)) > last)
+		{
+
+			error = std::numeric_limits<float>::infinity();
+			continue;
+
+		}
+
+		float hypotenuse = 0.5f * (fieldHeights[(fieldStride * ay) + ax] + fieldHeights[(fieldStride * by) + bx]);
+		float triangleError = std::fabs(fieldHeights[(fieldStride * y) + x] - hypotenuse);
+
+		if (hasChildren)
+		{
+
+			// The children's hypotenuses are this triangle's legs
+			float leftError = errors[(errorSize * ((ay + cy) / 2)) + ((ax + cx) / 2)];
+			float rightError = errors[(errorSize * ((by + cy) / 2)) + ((bx + cx) / 2)];
+
+			triangleError += std::max(leftError, rightError);
+
+		}
+
+		error = std::max(error, triangleError);
+
+	}
+
+	errors[(errorSize * y) + x] = error;
+
+}
+
+int TerrainAdaptiveMesh::Triangulate(const HeightField& field, float maxError)
+{
+
+	delete[] vertices;
+	delete[] indices;
+	vertices = 0;
+	indices = 0;
+	vertexCount = 0;
+	indexCount = 0;
+
+	int fieldResolution = field.GetResolution();
+
+	stats.vertices = 0;
+	stats.triangles = 0;
+	stats.gridTriangles = 2 * (fieldResolution - 1) * (fieldResolution - 1);
+	stats.errorBound = maxError;
+	stats.maxError = 0.0f;
+
+	if (errors == 0 || fieldResolution != resolution)
+	{
+
+		return 0;
+
+	}
+
+	heights = field.GetHeights();
+	stride = field.GetStride();
+
+	// Triangles reaching past the grid have infinite errors, which an infinite bound would let through
+	maxError = std::min(maxError, FLT_MAX);
+
+	std::fill(vertexMap, vertexMap + (resolution * resolution), -1);
+
+	// Walk down the triangles once to find out how many there are and which grid points they use
+	int tileSize = errorSize - 1;
+
+	AddTriangle(0, 0, tileSize, tileSize, tileSize, 0, maxError, true);
+	AddTriangle(tileSize, tileSize, 0, 0, 0, tileSize, maxError, true);
+
+	for (int k = 0; k < resolution * resolution; k++)
+	{
+
+		if (vertexMap[k] != -1)
+		{
+
+			vertexCount++;
+
+		}
+
+	}
+
+	vertices = new TerrainVertex[vertexCount];
+	indices = new unsigned int[indexCount];
+
+	int vertex = 0;
+
+	for (int j = 0; j < resolution; j++)
+	{
+
+		for (int i = 0; i < resolution; i++)
+		{
+
+			int k = (resolution * j) + i;
+
+			if (vertexMap[k] != -1)
+			{
+
+				BuildTerrainVertex(field, i, j, vertices[vertex]);
+				vertexMap[k] = vertex++;
+
+			}
+
+		}
+
+	}
+
+	// Then again to write them out
+	indexCount = 0;
+
+	AddTriangle(0, 0, tileSize, tileSize, tileSize, 0, maxError, false);
+	AddTriangle(tileSize, tileSize, 0, 0, 0, tileSize, maxError, false);
+
+	stats.vertices = vertexCount;
+	stats.triangles = indexCount / 3;
+
+	return stats.triangles;
+
+}
+
+void TerrainAdaptiveMesh::AddTriangle(int ax, int ay, int bx, int by, int cx, int cy, float maxError, bool counting)
+{
+
+	int last = resolution - 1;
+
+	if (std::min(ax, std::min(bx, cx)) >= last || std::min(ay, std::min(by, cy)) >= last)
+	{
+
+		return;
+
+	}
+
+	int mx = (ax + bx) / 2;
+	int my = (ay + by) / 2;
+
+	// Triangles with legs a quad long are halves of the grid's quads, and can't be split any further
+	if ((std::abs(ax - cx) + std::abs(ay - cy)) > 1 && errors[(errorSize * my) + mx] > maxError)
+	{
+
+		AddTriangle(cx, cy, ax, ay, mx, my, maxError, counting);
+		AddTriangle(bx, by, cx, cy, mx, my, maxError, counting);
+		return;
+
+	}
+
+	int a = (resolution * ay) + ax;
+	int b = (resolution * by) + bx;
+	int c = (resolution * cy) + cx;
+
+	if (counting)
+	{
+
+		vertexMap[a] = 0;
+		vertexMap[b] = 0;
+		vertexMap[c] = 0;
+		indexCount += 3;
+		return;
+
+	}
+
+	// Splitting keeps every triangle wound the opposite way from the grid's quads, so they're put out backwards
+	indices[indexCount++] = vertexMap[a];
+	indices[indexCount++] = vertexMap[c];
+	indices[indexCount++] = vertexMap[b];
+
+	stats.maxError = std::max(stats.maxError, TriangleError(ax, ay, bx, by, cx, cy));
+
+}
+
+float TerrainAdaptiveMesh::TriangleError(int ax, int ay, int bx, int by, int cx, int cy) const
+{
+
+	// Halves of the grid's quads have no grid points but their corners
+	if ((std::abs(ax - cx) + std::abs(ay - cy)) <= 1)
+	{
+
+		return 0.0f;
+
+	}
+
+	float heightA = heights[(stride * ay) + ax];
+	float heightB = heights[(stride * by) + bx];
+	float heightC = heights[(stride * cy) + cx];
+
+	// Twice the signed area, the edge functions below come out with the same sign for points inside
+	int area = ((bx - ax) * (cy - ay)) - ((by - ay) * (cx - ax));
+	int sign = area < 0 ? -1 : 1;
+	float inverseArea = 1.0f / (float)(sign * area);
+
+	int minX = std::min(ax, std::min(bx, cx));
+	int maxX = std::max(ax, std::max(bx, cx));
+	int minY = std::min(ay, std::min(by, cy));
+	int maxY = std::max(ay, std::max(by, cy));
+
+	float error = 0.0f;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+
+		const float* row = heights + (stride * y);
+
+		for (int x = minX; x <= maxX; x++)
+		{
+
+			// Each weight is the area of the triangle the point makes with the edge opposite that corner
+			int weightA = sign * (((bx - x) * (cy - y)) - ((by - y) * (cx - x)));
+			int weightB = sign * (((cx - x) * (ay - y)) - ((cy - y) * (ax - x)));
+			int weightC = sign * (((ax - x) * (by - y)) - ((ay - y) * (bx - x)));
+
+			if (weightA < 0 || weightB < 0 || weightC < 0)
+			{
+
+				continue;
+
+			}
+
+			float height = ((weightA * heightA) + (weightB * heightB) + (weightC * heightC)) * inverseArea;
+			error = std::max(error, std::fabs(row[x] - height));
+
+		}
+
+	}
+
+	return error;
+
+}
+
+const TerrainAdaptiveMesh::TriangulationStats& TerrainAdaptiveMesh::GetTriangulationStats() const
+{
+
+	return stats;
+
+}
+
+int TerrainAdaptiveMesh::GetVertexCount() const
+{
+
+	return vertexCount;
+
+}
+
+int TerrainAdaptiveMesh::GetIndexCount() const
+{
+
+	return indexCount;
+
+}
+
+const TerrainVertex* TerrainAdaptiveMesh::GetVertices() const
+{
+
+	return vertices;
+
+}
+
+const unsigned int* TerrainAdaptiveMesh::GetIndices() const
+{
+
+	return indices;
+
+}
+
+int TerrainAdaptiveMesh::GetIndexSize() const
+{
+
+	return vertexCount <= 65536 ? 2 : 4;
+
+}
+
+void TerrainAdaptiveMesh::BuildIndices(unsigned short* shortIndices) const
+{
+
+	for (int k = 0; k < indexCount; k++)
+	{
+
+		shortIndices[k] = (unsigned short)indices[k];
+
+	}
+
+}
@@ -0,0 +1,94 @@
+// TerrainAdaptiveMesh.h
+// Turns a heightfield into a triangle mesh whose triangles stay within a given vertical error of the heights, so flat ground
+// like the sea floor or smoothed plains is covered by a few large triangles and only rough ground keeps the grid's density.
+// Nothing here needs DirectX, so it can be run straight after a bake.
+//
+// The mesh is a right-triangulated irregular network (RTIN). The grid is cut in two along its diagonal, and each right
+// triangle is split in half from its right angle to the middle of its hypotenuse, over and over down to the grid's own quads.
+// The two triangles sharing a hypotenuse are always split together, and a triangle is only split once its parent has been,
+// which keeps the mesh free of cracks and T-junctions.
+// BuildErrors works out how far the heights can be from every triangle in that hierarchy once, after which Triangulate picks
+// the triangles for any error bound in a single walk down it. A triangle's error adds the height of its hypotenuse's middle
+// above or below the hypotenuse to the largest of its children's errors, which can only overestimate, so the bound holds
+// Reference: Evans, Kirkpatrick and Townsend, Right-Triangulated Irregular Networks, 2001
+
+#pragma once
+#include "TerrainGeometry.h"
+
+class TerrainAdaptiveMesh
+{
+
+public:
+
+	// What the last Triangulate call built
+	struct TriangulationStats
+	{
+
+		int vertices;				// Grid points the triangles use
+		int triangles;				// Triangles in the mesh
+		int gridTriangles;			// Triangles in the full grid, two a quad, for comparison
+		float errorBound;			// Largest vertical error asked for
+		float maxError;				// Furthest any grid point is above or below the triangles, measured over every one of them
+
+	};
+
+	TerrainAdaptiveMesh();
+	~TerrainAdaptiveMesh();
+
+	// Works out the error of every triangle the mesh could use from the field's heights, which needs doing again whenever they
+	// change. Grids that aren't 2^n + 1 points along a side are split as if they were, with every triangle that reaches past
+	// the last row or column split until it doesn't, so those grids keep the full density along their top and right edges
+	void BuildErrors(const HeightField& field);
+
+	// Picks the largest triangles that stay within maxError of the heights and builds their vertices and indices, returning how
+	// many triangles there are. The field has to be the one BuildErrors last saw, the mesh comes out empty if its resolution
+	// has changed since. The normals are the field's own, or straight up when it has none
+	int Triangulate(const HeightField& field, float maxError);
+
+	const TriangulationStats& GetTriangulationStats() const;
+
+	// The vertices are the grid points in row-major order, each laid out as BuildTerrainVertices would, and the indices are
+	// a triangle list wound the same way as the full grid's
+	int GetVertexCount() const;
+	int GetIndexCount() const;
+	const TerrainVertex* GetVertices() const;
+	const unsigned int* GetIndices() const;
+
+	// Bytes per index, 2 while every vertex can be reached with 16 bit indices and 4 after that
+	int GetIndexSize() const;
+
+	// Copies the indices down to 16 bits for meshes GetIndexSize gives 2 bytes for, needs room for GetIndexCount entries
+	void BuildIndices(unsigned short* indices) const;
+
+private:
+
+	// Sets the error of the diamond of the two triangles sharing the hypotenuse from (x - rx, y - ry) to (x + rx, y + ry),
+	// whose right angles are at (x + px, y + py) and (x - px, y - py)
+	void DiamondError(const float* fieldHeights, int fieldStride, int x, int y, int rx, int ry, int px, int py);
+
+	// Splits the triangle with hypotenuse a to b and right angle at c for as long as its error is above maxError. While
+	// counting is set it only marks the grid points the triangles use and counts them, otherwise it writes their indices
+	// and measures how far the heights under them are from them
+	void AddTriangle(int ax, int ay, int bx, int by, int cx, int cy, float maxError, bool counting);
+
+	// Furthest any grid point under the triangle is above or below it
+	float TriangleError(int ax, int ay, int bx, int by, int cx, int cy) const;
+
+	// Error of each diamond, by the grid point in the middle of its hypotenuse, over the whole 2^n + 1 square
+	float* errors;
+	int errorSize;
+
+	int resolution;
+	const float* heights;
+	int stride;
+
+	// Vertex each grid point became, or -1 if no triangle uses it
+	int* vertexMap;
+
+	TerrainVertex* vertices;
+	unsigned int* indices;
+	int vertexCount, indexCount;
+
+	TriangulationStats stats;
+
+};
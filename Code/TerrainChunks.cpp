@@ -0,0 +1,621 @@
+#include "TerrainChunks.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+TerrainFrustum ExtractTerrainFrustum(const float* matrix)
+{
+
+	// A position p comes out in clip space as p * matrix, so each clip coordinate is p dotted with a column of the matrix,
+	// and each side of the frustum is where one coordinate meets -w, w or 0 (Gribb and Hartmann)
+	float column[4][4];
+
+	for (int c = 0; c < 4; c++)
+	{
+
+		for (int r = 0; r < 4; r++)
+		{
+
+			column[c][r] = matrix[(4 * r) + c];
+
+		}
+
+	}
+
+	TerrainFrustum frustum;
+
+	for (int k = 0; k < 4; k++)
+	{
+
+		frustum.planes[0][k] = column[3][k] + column[0][k];		// Left, x >= -w
+		frustum.planes[1][k] = column[3][k] - column[0][k];		// Right, x <= w
+		frustum.planes[2][k] = column[3][k] + column[1][k];		// Bottom, y >= -w
+		frustum.planes[3][k] = column[3][k] - column[1][k];		// Top, y <= w
+		frustum.planes[4][k] = column[2][k];					// Near, z >= 0
+		frustum.planes[5][k] = column[3][k] - column[2][k];		// Far, z <= w
+
+	}
+
+	return frustum;
+
+}
+
+TerrainChunks::TerrainChunks()
+	: chunks(0), chunkCount(0), chunksX(0), chunksZ(0), chunkSize(TERRAIN_CHUNK_SIZE), levelCount(1), resolution(0),
+	vertexCount(0), indexCount(0), levelZeroIndexCount(0)
+{
+
+}
+
+TerrainChunks::~TerrainChunks()
+{
+
+	delete[] chunks;
+
+}
+
+void TerrainChunks::Layout(int lresolution, int lchunkSize)
+{
+
+	delete[] chunks;
+	chunks = 0;
+
+	resolution = lresolution;
+	chunkSize = std::min(std::max(lchunkSize, 1), 1 << (TERRAIN_CHUNK_MAX_LEVELS - 1));
+
+	// Each level doubles the step until a single quad covers the chunk
+	levelCount = 1;
+
+	for (int step = 1; step < chunkSize; step *= 2)
+	{
+
+		levelCount++;
+
+	}
+
+	// A heightfield with a single vertex has no quads to put in a chunk
+	int cells = std::max(resolution - 1, 0);
+
+	chunksX = (cells + chunkSize - 1) / chunkSize;
+	chunksZ = chunksX;
+	chunkCount = chunksX * chunksZ;
+	vertexCount = 0;
+	indexCount = 0;
+	levelZeroIndexCount = 0;
+
+	if (chunkCount == 0)
+	{
+
+		return;
+
+	}
+
+	chunks = new TerrainChunk[chunkCount];
+
+	for (int z = 0; z < chunksZ; z++)
+	{
+
+		for (int x = 0; x < chunksX; x++)
+		{
+
+			TerrainChunk& chunk = chunks[(chunksX * z) + x];
+
+			chunk.rowBegin = chunkSize * z;
+			chunk.rowEnd = std::min(chunk.rowBegin + chunkSize + 1, resolution);
+			chunk.columnBegin = chunkSize * x;
+			chunk.columnEnd = std::min(chunk.columnBegin + chunkSize + 1, resolution);
+
+			int rows = chunk.rowEnd - chunk.rowBegin;
+			int columns = chunk.columnEnd - chunk.columnBegin;
+
+			chunk.vertexStart = vertexCount;
+			chunk.vertexCount = (rows * columns) + (2 * (rows + columns));
+
+			for (int l = 0; l < levelCount; l++)
+			{
+
+				chunk.levelIndexCount[l] = GetTerrainIndexCount(rows, columns, 1 << l) +
+					BuildSkirtIndices(chunk, 1 << l, (unsigned int*)0);
+				chunk.levelError[l] = 0.0f;
+
+			}
+
+			chunk.level = 0;
+			chunk.minX = chunk.minY = chunk.minZ = 0.0f;
+			chunk.maxX = chunk.maxY = chunk.maxZ = 0.0f;
+			chunk.dirty = true;
+
+			vertexCount += chunk.vertexCount;
+
+		}
+
+	}
+
+	// Level by level, so level 0 of every chunk comes first
+	for (int l = 0; l < levelCount; l++)
+	{
+
+		for (int c = 0; c < chunkCount; c++)
+		{
+
+			chunks[c].levelIndexStart[l] = indexCount;
+			indexCount += chunks[c].levelIndexCount[l];
+
+		}
+
+		if (l == 0)
+		{
+
+			levelZeroIndexCount = indexCount;
+
+		}
+
+	}
+
+}
+
+int TerrainChunks::GetChunkCount() const
+{
+
+	return chunkCount;
+
+}
+
+const TerrainChunk& TerrainChunks::GetChunk(int chunk) const
+{
+
+	return chunks[chunk];
+
+}
+
+int TerrainChunks::GetLevelCount() const
+{
+
+	return levelCount;
+
+}
+
+int TerrainChunks::GetVertexCount() const
+{
+
+	return vertexCount;
+
+}
+
+int TerrainChunks::GetIndexCount() const
+{
+
+	return indexCount;
+
+}
+
+int TerrainChunks::GetLevelZeroIndexCount() const
+{
+
+	return levelZeroIndexCount;
+
+}
+
+int TerrainChunks::GetIndexSize() const
+{
+
+	return vertexCount <= 65536 ? 2 : 4;
+
+}
+
+void TerrainChunks::BuildIndices(unsigned short* indices) const
+{
+
+	BuildChunkIndices(indices);
+
+}
+
+void TerrainChunks::BuildIndices(unsigned int* indices) const
+{
+
+	BuildChunkIndices(indices);
+
+}
+
+template <typename Index>
+void TerrainChunks::BuildChunkIndices(Index* indices) const
+{
+
+	for (int c = 0; c < chunkCount; c++)
+	{
+
+		const TerrainChunk& chunk = chunks[c];
+		int rows = chunk.rowEnd - chunk.rowBegin;
+		int columns = chunk.columnEnd - chunk.columnBegin;
+
+		for (int l = 0; l < levelCount; l++)
+		{
+
+			Index* levelIndices = indices + chunk.levelIndexStart[l];
+
+			BuildTerrainIndices(chunk.rowBegin, chunk.rowEnd, chunk.columnBegin, chunk.columnEnd, 1 << l, chunk.vertexStart,
+				levelIndices);
+			BuildSkirtIndices(chunk, 1 << l, levelIndices + GetTerrainIndexCount(rows, columns, 1 << l));
+
+		}
+
+	}
+
+}
+
+// Joins count edge vertices, edgeSpacing apart from edge on, to the skirt vertices below them from skirt on, taking every
+// step-th one and the last. Facing is which way round the triangles go so they face out of the chunk
+// Only counts the indices when indices is null
+template <typename Index>
+static int AddSkirt(int edge, int edgeSpacing, int skirt, int count, int step, bool facing, Index* indices)
+{
+
+	int index = 0;
+
+	for (int k = 0; k < count - 1; k += step)
+	{
+
+		int next = std::min(k + step, count - 1);
+
+		if (indices != 0)
+		{
+
+			Index upper = (Index)(edge + (edgeSpacing * k));
+			Index upperNext = (Index)(edge + (edgeSpacing * next));
+			Index lower = (Index)(skirt + k);
+			Index lowerNext = (Index)(skirt + next);
+
+			if (facing)
+			{
+
+				indices[index] = upper;
+				indices[index + 1] = upperNext;
+				indices[index + 2] = lowerNext;
+
+				indices[index + 3] = upper;
+				indices[index + 4] = lowerNext;
+				indices[index + 5] = lower;
+
+			}
+			else
+			{
+
+				indices[index] = upper;
+				indices[index + 1] = lowerNext;
+				indices[index + 2] = upperNext;
+
+				indices[index + 3] = upper;
+				indices[index + 4] = lower;
+				indices[index + 5] = lowerNext;
+
+			}
+
+		}
+
+		index += 6;
+
+	}
+
+	return index;
+
+}
+
+template <typename Index>
+int TerrainChunks::BuildSkirtIndices(const TerrainChunk& chunk, int step, Index* indices) const
+{
+
+	int rows = chunk.rowEnd - chunk.rowBegin;
+	int columns = chunk.columnEnd - chunk.columnBegin;
+
+	int base = chunk.vertexStart;
+	int skirt = base + (rows * columns);
+	int count = 0;
+
+	// The edges of the whole map have nothing beside them to crack against
+	if (chunk.rowBegin > 0)
+	{
+
+		count += AddSkirt(base, 1, skirt, columns, step, false, indices != 0 ? indices + count : indices);
+
+	}
+
+	if (chunk.rowEnd < resolution)
+	{
+
+		count += AddSkirt(base + (columns * (rows - 1)), 1, skirt + columns, columns, step, true,
+			indices != 0 ? indices + count : indices);
+
+	}
+
+	if (chunk.columnBegin > 0)
+	{
+
+		count += AddSkirt(base, columns, skirt + (2 * columns), rows, step, true, indices != 0 ? indices + count : indices);
+
+	}
+
+	if (chunk.columnEnd < resolution)
+	{
+
+		count += AddSkirt(base + columns - 1, columns, skirt + (2 * columns) + rows, rows, step, false,
+			indices != 0 ? indices + count : indices);
+
+	}
+
+	return count;
+
+}
+
+void TerrainChunks::MarkDirty(int rowBegin, int rowEnd, int columnBegin, int columnEnd)
+{
+
+	// The normals one vertex outside the edit change with it
+	rowBegin = std::max(rowBegin - 1, 0);
+	rowEnd = std::min(rowEnd + 1, resolution);
+	columnBegin = std::max(columnBegin - 1, 0);
+	columnEnd = std::min(columnEnd + 1, resolution);
+
+	if ((rowBegin >= rowEnd) || (columnBegin >= columnEnd))
+	{
+
+		return;
+
+	}
+
+	// A grid point on the edge between two chunks belongs to both, so the first chunk is the one that ends on or after it
+	int firstX = std::max(((columnBegin + chunkSize - 1) / chunkSize) - 1, 0);
+	int lastX = std::min((columnEnd - 1) / chunkSize, chunksX - 1);
+	int firstZ = std::max(((rowBegin + chunkSize - 1) / chunkSize) - 1, 0);
+	int lastZ = std::min((rowEnd - 1) / chunkSize, chunksZ - 1);
+
+	for (int z = firstZ; z <= lastZ; z++)
+	{
+
+		for (int x = firstX; x <= lastX; x++)
+		{
+
+			chunks[(chunksX * z) + x].dirty = true;
+
+		}
+
+	}
+
+}
+
+void TerrainChunks::MarkAllDirty()
+{
+
+	for (int c = 0; c < chunkCount; c++)
+	{
+
+		chunks[c].dirty = true;
+
+	}
+
+}
+
+void TerrainChunks::BuildChunk(const HeightField& field, int c, TerrainVertex* vertices)
+{
+
+	TerrainChunk& chunk = chunks[c];
+	TerrainVertex* chunkVertices = vertices + chunk.vertexStart;
+
+	int rows = chunk.rowEnd - chunk.rowBegin;
+	int columns = chunk.columnEnd - chunk.columnBegin;
+	int gridCount = rows * columns;
+
+	BuildTerrainVertices(field, chunk.rowBegin, chunk.rowEnd, chunk.columnBegin, chunk.columnEnd, chunkVertices);
+
+	float minY = FLT_MAX;
+	float maxY = -FLT_MAX;
+
+	for (int v = 0; v < gridCount; v++)
+	{
+
+		minY = std::min(minY, chunkVertices[v].y);
+		maxY = std::max(maxY, chunkVertices[v].y);
+
+	}
+
+	// Whatever level a neighbour is drawn at, its edge is a line between heights on this edge, so it can't be lower than
+	// this chunk's lowest height, and a skirt down to there covers any gap
+	TerrainVertex* skirt = chunkVertices + gridCount;
+
+	for (int i = 0; i < columns; i++)
+	{
+
+		skirt[i] = chunkVertices[i];
+		skirt[columns + i] = chunkVertices[(columns * (rows - 1)) + i];
+
+	}
+
+	for (int j = 0; j < rows; j++)
+	{
+
+		skirt[(2 * columns) + j] = chunkVertices[columns * j];
+		skirt[(2 * columns) + rows + j] = chunkVertices[(columns * j) + columns - 1];
+
+	}
+
+	for (int v = 0; v < 2 * (rows + columns); v++)
+	{
+
+		skirt[v].y = minY;
+
+	}
+
+	// The grid points are packed row by row, so the first and last are opposite corners
+	chunk.minX = chunkVertices[0].x;
+	chunk.minY = minY;
+	chunk.minZ = chunkVertices[0].z;
+	chunk.maxX = chunkVertices[gridCount - 1].x;
+	chunk.maxY = maxY;
+	chunk.maxZ = chunkVertices[gridCount - 1].z;
+
+	// Keep the errors from going down with the level, so picking the coarsest level within a bound can start at the top
+	chunk.levelError[0] = 0.0f;
+
+	for (int l = 1; l < levelCount; l++)
+	{
+
+		chunk.levelError[l] = std::max(LevelError(chunk, chunkVertices, 1 << l), chunk.levelError[l - 1]);
+
+	}
+
+	chunk.dirty = false;
+
+}
+
+float TerrainChunks::LevelError(const TerrainChunk& chunk, const TerrainVertex* chunkVertices, int step) const
+{
+
+	int rows = chunk.rowEnd - chunk.rowBegin;
+	int columns = chunk.columnEnd - chunk.columnBegin;
+
+	// Same quads and diagonals as BuildTerrainIndices
+	int parity = (chunk.columnBegin + chunk.rowBegin) / step;
+	float error = 0.0f;
+
+	for (int m = 0, z0 = 0; z0 < rows - 1; m++, z0 += step)
+	{
+
+		int z1 = std::min(z0 + step, rows - 1);
+		float depth = 1.0f / (float)(z1 - z0);
+
+		for (int k = 0, x0 = 0; x0 < columns - 1; k++, x0 += step)
+		{
+
+			int x1 = std::min(x0 + step, columns - 1);
+			float width = 1.0f / (float)(x1 - x0);
+
+			float bottomLeft = chunkVertices[(columns * z0) + x0].y;
+			float bottomRight = chunkVertices[(columns * z0) + x1].y;
+			float upperLeft = chunkVertices[(columns * z1) + x0].y;
+			float upperRight = chunkVertices[(columns * z1) + x1].y;
+			bool split = (parity + k + m) % 2 != 0;
+
+			// Every grid point in the quad, its edges included, against whichever of its two triangles it's under
+			for (int j = z0; j <= z1; j++)
+			{
+
+				float fz = (float)(j - z0) * depth;
+				const TerrainVertex* row = chunkVertices + (columns * j);
+
+				for (int i = x0; i <= x1; i++)
+				{
+
+					float fx = (float)(i - x0) * width;
+					float height;
+
+					if (split)
+					{
+
+						// Split along the upper left to bottom right diagonal
+						height = fx + fz <= 1.0f ?
+							bottomLeft + (fx * (bottomRight - bottomLeft)) + (fz * (upperLeft - bottomLeft)) :
+							upperRight + ((1.0f - fx) * (upperLeft - upperRight)) + ((1.0f - fz) * (bottomRight - upperRight));
+
+					}
+					else
+					{
+
+						// Split along the bottom left to upper right diagonal
+						height = fx >= fz ?
+							bottomLeft + (fx * (bottomRight - bottomLeft)) + (fz * (upperRight - bottomRight)) :
+							bottomLeft + (fz * (upperLeft - bottomLeft)) + (fx * (upperRight - upperLeft));
+
+					}
+
+					error = std::max(error, std::fabs(row[i].y - height));
+
+				}
+
+			}
+
+		}
+
+	}
+
+	return error;
+
+}
+
+int TerrainChunks::CullChunks(const TerrainFrustum& frustum, int* visible) const
+{
+
+	int count = 0;
+
+	for (int c = 0; c < chunkCount; c++)
+	{
+
+		const TerrainChunk& chunk = chunks[c];
+		bool inside = true;
+
+		// The box is outside a plane when even its corner furthest along the plane's normal is behind it
+		for (int p = 0; p < 6 && inside; p++)
+		{
+
+			const float* plane = frustum.planes[p];
+
+			float x = plane[0] >= 0.0f ? chunk.maxX : chunk.minX;
+			float y = plane[1] >= 0.0f ? chunk.maxY : chunk.minY;
+			float z = plane[2] >= 0.0f ? chunk.maxZ : chunk.minZ;
+
+			inside = (plane[0] * x) + (plane[1] * y) + (plane[2] * z) + plane[3] >= 0.0f;
+
+		}
+
+		if (inside)
+		{
+
+			visible[count++] = c;
+
+		}
+
+	}
+
+	return count;
+
+}
+
+int TerrainChunks::SelectLevels(float cameraX, float cameraY, float cameraZ, float viewportHeight, float fieldOfView,
+	float maxScreenError)
+{
+
+	// Pixels a height difference of one covers at a distance of one
+	float pixelsPerUnit = viewportHeight / (2.0f * std::tan(0.5f * fieldOfView));
+	int triangles = 0;
+
+	for (int c = 0; c < chunkCount; c++)
+	{
+
+		TerrainChunk& chunk = chunks[c];
+
+		float dx = std::max(std::max(chunk.minX - cameraX, cameraX - chunk.maxX), 0.0f);
+		float dy = std::max(std::max(chunk.minY - cameraY, cameraY - chunk.maxY), 0.0f);
+		float dz = std::max(std::max(chunk.minZ - cameraZ, cameraZ - chunk.maxZ), 0.0f);
+		float distance = std::sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+		// Error on screen is error * pixelsPerUnit / distance, compared without dividing so a camera inside the box works
+		chunk.level = 0;
+
+		for (int l = levelCount - 1; l > 0; l--)
+		{
+
+			if (chunk.levelError[l] * pixelsPerUnit <= maxScreenError * distance)
+			{
+
+				chunk.level = l;
+				break;
+
+			}
+
+		}
+
+		triangles += chunk.levelIndexCount[chunk.level] / 3;
+
+	}
+
+	return triangles;
+
+}
@@ -0,0 +1,137 @@
+// TerrainChunks.h
+// Splits the terrain mesh into square chunks, so an edit only rebuilds the chunks it touches and only the chunks inside the
+// view frustum are drawn. Each chunk has its own run of vertices in the mesh buffers, a bounding box and a dirty flag.
+// Nothing here needs DirectX, so the culling, dirty tracking and level selection can be run and checked headless.
+//
+// Each chunk also has a run of triangles for every level of detail (geomipmapping). Level l joins up only every 2^l-th row
+// and column of the chunk's vertices, so it's drawn from the same vertices with a quarter of the triangles of the level
+// before. Every edge a chunk shares with another has a skirt, a strip hanging down from the edge to the chunk's lowest
+// height, which hides the cracks where neighbouring chunks drawn at different levels don't meet.
+// The index buffer holds level 0 of every chunk first, so drawing from the start of it still draws the whole terrain.
+
+#pragma once
+#include "TerrainGeometry.h"
+
+// Side of a chunk in quads
+#define TERRAIN_CHUNK_SIZE 64
+
+// Most levels of detail a chunk can have, enough for chunks of up to 128 quads
+#define TERRAIN_CHUNK_MAX_LEVELS 8
+
+struct TerrainChunk
+{
+
+	// Grid points the chunk covers, the last row and column are shared with the next chunk along
+	int rowBegin, rowEnd;
+	int columnBegin, columnEnd;
+
+	// Where its packed vertices start in the vertex buffer, and how many there are, the grid points followed by the
+	// bottoms of the skirts along its bottom, top, left and right edges
+	int vertexStart, vertexCount;
+
+	// Where the triangles of each level start in the index buffer, and how many indices there are, skirts included
+	int levelIndexStart[TERRAIN_CHUNK_MAX_LEVELS];
+	int levelIndexCount[TERRAIN_CHUNK_MAX_LEVELS];
+
+	// Furthest any grid point is above or below each level's triangles, 0 for level 0
+	float levelError[TERRAIN_CHUNK_MAX_LEVELS];
+
+	// Level SelectLevels picked, 0 until it's called
+	int level;
+
+	// Bounding box of the vertices, in the mesh's own space
+	float minX, minY, minZ;
+	float maxX, maxY, maxZ;
+
+	// Set when the heights under the chunk have changed since its vertices were last built
+	bool dirty;
+
+};
+
+// Six planes (a, b, c, d), each with the inside where a * x + b * y + c * z + d >= 0
+struct TerrainFrustum
+{
+
+	float planes[6][4];
+
+};
+
+// Frustum of a 4x4 world * view * projection matrix, stored row by row and used on row vectors (position * matrix) as
+// DirectXMath does, with depth from 0 to 1. The planes come out in the mesh's own space
+TerrainFrustum ExtractTerrainFrustum(const float* matrix);
+
+class TerrainChunks
+{
+
+public:
+
+	TerrainChunks();
+	~TerrainChunks();
+
+	// Lays chunks of chunkSize quads over a heightfield of the given resolution, the last row and column of chunks taking
+	// whatever is left over. Every chunk starts dirty, and gets its bounding box and errors when it's built
+	void Layout(int resolution, int chunkSize = TERRAIN_CHUNK_SIZE);
+
+	int GetChunkCount() const;
+	const TerrainChunk& GetChunk(int chunk) const;
+
+	// Levels of detail every chunk has, the last one being a single quad for a whole chunk
+	int GetLevelCount() const;
+
+	// Size of the buffers every chunk together needs
+	int GetVertexCount() const;
+	int GetIndexCount() const;
+
+	// Indices at the start of the index buffer that draw every chunk at level 0
+	int GetLevelZeroIndexCount() const;
+
+	// Bytes per index, 2 while every vertex can be reached with 16 bit indices and 4 after that
+	int GetIndexSize() const;
+
+	// Fills indices with every level of every chunk's triangles, pointing at each chunk's vertexStart
+	// The indices never change, so this only needs doing after Layout. Needs room for GetIndexCount entries
+	void BuildIndices(unsigned short* indices) const;
+	void BuildIndices(unsigned int* indices) const;
+
+	// Marks dirty every chunk whose vertices depend on the heights in rows [rowBegin, rowEnd) by columns
+	// [columnBegin, columnEnd). Normals reach one vertex further than the edit, so chunks just beside it are marked too
+	void MarkDirty(int rowBegin, int rowEnd, int columnBegin, int columnEnd);
+	void MarkAllDirty();
+
+	// Writes the chunk's vertices from the heightfield at its vertexStart, refits its bounding box, works out the error of
+	// each level and clears its dirty flag
+	void BuildChunk(const HeightField& field, int chunk, TerrainVertex* vertices);
+
+	// Puts the index of every chunk whose bounding box isn't wholly outside one of the planes into visible, which needs room
+	// for GetChunkCount entries, and returns how many there are. Chunks close to a corner of the frustum can be kept
+	// when they're just outside it, but no visible chunk is ever dropped
+	int CullChunks(const TerrainFrustum& frustum, int* visible) const;
+
+	// Picks the coarsest level for each chunk whose error stays within maxScreenError pixels, seen from the camera at the
+	// nearest point of the chunk's bounding box on a viewport viewportHeight pixels high with a vertical field of view of
+	// fieldOfView radians. The camera is in the mesh's own space. Returns how many triangles every chunk together has at
+	// the levels picked
+	int SelectLevels(float cameraX, float cameraY, float cameraZ, float viewportHeight, float fieldOfView, float maxScreenError);
+
+private:
+
+	template <typename Index>
+	void BuildChunkIndices(Index* indices) const;
+
+	// Adds the skirt triangles along the edges of the chunk it shares with others at the given level, returning how many
+	// indices that takes, or only counts them when indices is null
+	template <typename Index>
+	int BuildSkirtIndices(const TerrainChunk& chunk, int step, Index* indices) const;
+
+	// Furthest the heights of the chunk's packed vertices are from the triangles of the level with the given step
+	float LevelError(const TerrainChunk& chunk, const TerrainVertex* chunkVertices, int step) const;
+
+	TerrainChunk* chunks;
+	int chunkCount;
+	int chunksX, chunksZ;
+	int chunkSize;
+	int levelCount;
+	int resolution;
+	int vertexCount, indexCount, levelZeroIndexCount;
+
+};
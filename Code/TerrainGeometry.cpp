@@ -0,0 +1,253 @@
+#include "TerrainGeometry.h"
+#include <algorithm>
+
+// Texture coordinates move on this much per vertex, so the texture repeats every ten quads
+static const float TERRAIN_UV_INCREMENT = 0.1f;
+
+int GetTerrainVertexCount(int resolution)
+{
+
+	return resolution * resolution;
+
+}
+
+int GetTerrainIndexCount(int resolution)
+{
+
+	return (resolution - 1) * (resolution - 1) * 6;
+
+}
+
+int GetTerrainIndexSize(int resolution)
+{
+
+	return GetTerrainVertexCount(resolution) <= 65536 ? 2 : 4;
+
+}
+
+void BuildTerrainVertices(const HeightField& field, TerrainVertex* vertices)
+{
+
+	int resolution = field.GetResolution();
+
+	BuildTerrainVertices(field, 0, resolution, 0, resolution, vertices);
+
+}
+
+void BuildTerrainVertices(const HeightField& field, int rowBegin, int rowEnd, int columnBegin, int columnEnd, TerrainVertex* vertices)
+{
+
+	int resolution = field.GetResolution();
+	int stride = field.GetStride();
+	const float* heights = field.GetHeights();
+	const HeightField::VectorType* normals = field.GetNormals();
+
+	int width = columnEnd - columnBegin;
+	int height = rowEnd - rowBegin;
+
+	// Work out the positions along each axis once rather than for every vertex
+	float* columnX = new float[width];
+	float* rowZ = new float[height];
+
+	for (int i = 0; i < width; i++)
+	{
+
+		columnX[i] = field.PositionX(columnBegin + i);
+
+	}
+
+	for (int j = 0; j < height; j++)
+	{
+
+		rowZ[j] = field.PositionZ(rowBegin + j);
+
+	}
+
+	for (int j = 0; j < height; j++)
+	{
+
+		TerrainVertex* row = vertices + (width * j);
+		const float* heightRow = heights + (stride * (rowBegin + j)) + columnBegin;
+
+		// The first row of quads starts its texture one step below zero
+		float v = TERRAIN_UV_INCREMENT * (rowBegin + j - 1);
+
+		for (int i = 0; i < width; i++)
+		{
+
+			row[i].x = columnX[i];
+			row[i].y = heightRow[i];
+			row[i].z = rowZ[j];
+			row[i].u = TERRAIN_UV_INCREMENT * (columnBegin + i);
+			row[i].v = v;
+
+		}
+
+		// Without normals the terrain is lit as if it were flat
+		if (normals != 0)
+		{
+
+			const HeightField::VectorType* normalRow = normals + (resolution * (rowBegin + j)) + columnBegin;
+
+			for (int i = 0; i < width; i++)
+			{
+
+				row[i].nx = normalRow[i].x;
+				row[i].ny = normalRow[i].y;
+				row[i].nz = normalRow[i].z;
+
+			}
+
+		}
+		else
+		{
+
+			for (int i = 0; i < width; i++)
+			{
+
+				row[i].nx = 0.0f;
+				row[i].ny = 1.0f;
+				row[i].nz = 0.0f;
+
+			}
+
+		}
+
+	}
+
+	delete[] columnX;
+	delete[] rowZ;
+
+}
+
+void BuildTerrainVertex(const HeightField& field, int i, int j, TerrainVertex& vertex)
+{
+
+	const float* heights = field.GetHeights();
+	const HeightField::VectorType* normals = field.GetNormals();
+
+	vertex.x = field.PositionX(i);
+	vertex.y = heights[(field.GetStride() * j) + i];
+	vertex.z = field.PositionZ(j);
+	vertex.u = TERRAIN_UV_INCREMENT * i;
+	vertex.v = TERRAIN_UV_INCREMENT * (j - 1);
+
+	if (normals != 0)
+	{
+
+		const HeightField::VectorType& normal = normals[(field.GetResolution() * j) + i];
+
+		vertex.nx = normal.x;
+		vertex.ny = normal.y;
+		vertex.nz = normal.z;
+
+	}
+	else
+	{
+
+		vertex.nx = 0.0f;
+		vertex.ny = 1.0f;
+		vertex.nz = 0.0f;
+
+	}
+
+}
+
+int GetTerrainIndexCount(int rows, int columns, int step)
+{
+
+	// Every step-th row and column, and always the last
+	int quadRows = (rows - 1 + step - 1) / step;
+	int quadColumns = (columns - 1 + step - 1) / step;
+
+	return quadRows * quadColumns * 6;
+
+}
+
+template <typename Index>
+static void BuildQuiltIndices(int rowBegin, int rowEnd, int columnBegin, int columnEnd, int step, int baseVertex, Index* indices)
+{
+
+	int width = columnEnd - columnBegin;
+	int height = rowEnd - rowBegin;
+	int index = 0;
+
+	// The pattern follows the quad's place on the whole grid, so regions built apart still line up
+	int parity = (columnBegin + rowBegin) / step;
+
+	for (int m = 0, j = 0; j < (height - 1); m++, j += step)
+	{
+
+		int nextJ = std::min(j + step, height - 1);
+
+		for (int k = 0, i = 0; i < (width - 1); k++, i += step)
+		{
+
+			int nextI = std::min(i + step, width - 1);
+
+			// Corners are (i, j) bottom left, (nextI, j) bottom right, (i, nextJ) upper left, (nextI, nextJ) upper right
+			Index bottomLeft = (Index)(baseVertex + (width * j) + i);
+			Index bottomRight = (Index)(baseVertex + (width * j) + nextI);
+			Index upperLeft = (Index)(baseVertex + (width * nextJ) + i);
+			Index upperRight = (Index)(baseVertex + (width * nextJ) + nextI);
+
+			if ((parity + k + m) % 2 != 0)
+			{
+
+				// Split along the upper left to bottom right diagonal
+				indices[index++] = upperLeft;
+				indices[index++] = bottomLeft;
+				indices[index++] = bottomRight;
+
+				indices[index++] = upperLeft;
+				indices[index++] = bottomRight;
+				indices[index++] = upperRight;
+
+			}
+			else
+			{
+
+				// Split along the bottom left to upper right diagonal
+				indices[index++] = bottomLeft;
+				indices[index++] = upperRight;
+				indices[index++] = upperLeft;
+
+				indices[index++] = bottomLeft;
+				indices[index++] = bottomRight;
+				indices[index++] = upperRight;
+
+			}
+
+		}
+
+	}
+
+}
+
+void BuildTerrainIndices(int resolution, unsigned short* indices)
+{
+
+	BuildQuiltIndices(0, resolution, 0, resolution, 1, 0, indices);
+
+}
+
+void BuildTerrainIndices(int resolution, unsigned int* indices)
+{
+
+	BuildQuiltIndices(0, resolution, 0, resolution, 1, 0, indices);
+
+}
+
+void BuildTerrainIndices(int rowBegin, int rowEnd, int columnBegin, int columnEnd, int step, int baseVertex, unsigned short* indices)
+{
+
+	BuildQuiltIndices(rowBegin, rowEnd, columnBegin, columnEnd, step, baseVertex, indices);
+
+}
+
+void BuildTerrainIndices(int rowBegin, int rowEnd, int columnBegin, int columnEnd, int step, int baseVertex, unsigned int* indices)
+{
+
+	BuildQuiltIndices(rowBegin, rowEnd, columnBegin, columnEnd, step, baseVertex, indices);
+
+}
@@ -0,0 +1,52 @@
+// TerrainGeometry.h
+// Builds the indexed triangle mesh for a heightfield without touching DirectX, so the vertex building can be run and timed headless.
+// Every grid point is one vertex, shared by the triangles around it, and the index buffer joins them up into two triangles a quad.
+// The "quilt" pattern alternates the diagonal that splits each quad, so neighbouring quads never share a diagonal direction.
+
+#pragma once
+#include "HeightField.h"
+
+// Same layout as BaseMesh::VertexType (position, texture, normal)
+struct TerrainVertex
+{
+
+	float x, y, z;
+	float u, v;
+	float nx, ny, nz;
+
+};
+
+// Number of vertices BuildTerrainVertices writes for a heightfield of the given resolution, one per grid point
+int GetTerrainVertexCount(int resolution);
+
+// Number of indices BuildTerrainIndices writes, 6 per quad
+int GetTerrainIndexCount(int resolution);
+
+// Bytes per index, 2 while every vertex can be reached with 16 bit indices and 4 after that
+int GetTerrainIndexSize(int resolution);
+
+// Fills vertices with the grid points in row-major order, vertex (resolution * j) + i is column i of row j
+// Needs room for GetTerrainVertexCount entries
+void BuildTerrainVertices(const HeightField& field, TerrainVertex* vertices);
+
+// Same as above for only the grid points in rows [rowBegin, rowEnd) by columns [columnBegin, columnEnd), packed together in
+// row-major order. Needs room for (rowEnd - rowBegin) * (columnEnd - columnBegin) entries
+void BuildTerrainVertices(const HeightField& field, int rowBegin, int rowEnd, int columnBegin, int columnEnd, TerrainVertex* vertices);
+
+// Same as above for the single grid point at column i of row j
+void BuildTerrainVertex(const HeightField& field, int i, int j, TerrainVertex& vertex);
+
+// Fills indices with the quilted triangle list over the vertices, needs room for GetTerrainIndexCount entries
+// The 16 bit version is only for resolutions GetTerrainIndexSize gives 2 bytes for
+void BuildTerrainIndices(int resolution, unsigned short* indices);
+void BuildTerrainIndices(int resolution, unsigned int* indices);
+
+// Number of indices the region version of BuildTerrainIndices writes for rows by columns grid points at the given step
+int GetTerrainIndexCount(int rows, int columns, int step);
+
+// Same as above for the quads between the packed vertices of a region built with BuildTerrainVertices, which start at
+// baseVertex in the vertex buffer. Only every step-th row and column is joined up, along with the last ones, to make a
+// coarser mesh over the same vertices. The diagonals follow the region's place on the grid, so it matches the whole mesh
+// Needs room for GetTerrainIndexCount(rowEnd - rowBegin, columnEnd - columnBegin, step) entries
+void BuildTerrainIndices(int rowBegin, int rowEnd, int columnBegin, int columnEnd, int step, int baseVertex, unsigned short* indices);
+void BuildTerrainIndices(int rowBegin, int rowEnd, int columnBegin, int columnEnd, int step, int baseVertex, unsigned int* indices);
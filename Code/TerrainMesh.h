@@ -2,36 +2,43 @@
 // Generates a plane mesh based on resolution, which can be manipulated using a heightmap.
 // Uses "quilt" pattern to build a series of quads across the mesh.
 // Adapted from a combination of the CMP301 plane mesh, the CMP301 quad mesh, and the Rastertek terrain mesh provided in the terrain generation tutorials
+// The terrain itself lives in a HeightField, this class turns it into vertex and index buffers
+// The buffers are split into TerrainChunks, so edits only rebuild the chunks they touch and only visible chunks are drawn,
+// each at a level of detail picked from its distance to the camera
 
 #ifndef _TERRAINMESH_H_
 #define _TERRAINMESH_H_
 
 #include "../DXFramework/BaseMesh.h"
-#include "ImprovedNoise.h"
-#include "SimplexNoise.h"
+#include "HeightField.h"
+#include "TerrainChunks.h"
 
 class TerrainMesh : public BaseMesh
 {
 
-	struct HeightMapType
-	{
+public:
 
-		float x, y, z;
-		float nx, ny, nz;
+	TerrainMesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ImprovedNoise* perlinNoise, SimplexNoise* simplexNoise, int resolution = 100);
+	~TerrainMesh();
 
-	};
+	HeightField& GetHeightField();
 
-	struct VectorType
-	{
+	// Sets how many threads are used to build the terrain, 0 uses every hardware thread
+	// The generated terrain is identical whatever the thread count
+	void SetThreadCount(int threadCount);
+	int GetThreadCount() const;
 
-		float x, y, z;
+	// See HeightField::SetLayerCacheEnabled
+	void SetLayerCacheEnabled(bool enabled);
 
-	};
+	// See HeightField::SetScrollEnabled
+	void SetScrollEnabled(bool enabled);
 
-public:
+	// See HeightField::SetBoundaryMode
+	void SetBoundaryMode(BoundaryMode mode);
 
-	TerrainMesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ImprovedNoise* perlinNoise, SimplexNoise* simplexNoise, int resolution = 100);
-	~TerrainMesh();
+	// See HeightField::SetSmoothingDoubleBuffered
+	void SetSmoothingDoubleBuffered(bool enabled);
 
 	// Function for generating the heightmap using fractional Brownian motion alongside Perlin noise or Simplex noise
 	void GenerateHeightMap(float offsetX, float offsetZ, float frequency, float amplitude, bool ridged, bool simplex, 
@@ -40,31 +47,79 @@ public:
 	// Function for smoothing out generated terrain within given height bounds
 	void SmoothingFunction(float smoothingWeight, float upperBound, float lowerBound);
 
+	// See HeightField::SeparableSmoothing
+	void SeparableSmoothing(SmoothingFilter filter, int radius, int passes, float smoothingWeight, float upperBound, float lowerBound);
+
 	// Thermal erosion simulates material breaking loose and sliding down slopes over time
 	// Results in generally smoother, flatter terrain
 	// Reference implementation: http://web.mit.edu/cesium/Public/terrain.pdf
 	void ThermalErosion(int erosionIterations);
 
+	// See HeightField::ParallelThermalErosion
+	void ParallelThermalErosion(int erosionIterations);
+
+	// See HeightField::SetThermalErosionConvergence
+	void SetThermalErosionConvergence(bool enabled, float tolerance = 0.0f);
+
+	// See HeightField::PyramidThermalErosion
+	void PyramidThermalErosion(int erosionIterations, int levels);
+
 	// Hydraulic erosion simulates the effects of water on terrain over time by depositing droplets over terrain
 	// Results in ridged, rough terrain
 	// Reference implementation: https://github.com/vogtb/terrain-map/blob/master/landmap.js
 	void HydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence);
 
+	// See HeightField::ParallelHydraulicErosion
+	void ParallelHydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, int drops, float persistence,
+		unsigned int seed);
+
+	// See HeightField::PipeHydraulicErosion
+	void PipeHydraulicErosion(float carryingCapacity, float depositionSpeed, int iterations, float rainfall, float evaporation);
+
+	// Builds the vertex and index buffers from scratch, for the first time or when the resolution changes
 	void initBuffers(ID3D11Device* device);
 
+	// After the heights in rows [rowBegin, rowEnd) by columns [columnBegin, columnEnd) change, recalculates the normals around
+	// them, then rebuilds only the chunks they touch and uploads each one's vertices into the existing vertex buffer
+	// The indices are kept, so the cost follows the size of the edit rather than the terrain.
+	// Returns false if the resolution has changed since initBuffers, which then has to be called instead
+	bool UpdateBuffers(ID3D11DeviceContext* deviceContext, int rowBegin, int rowEnd, int columnBegin, int columnEnd);
+
+	// Same as above over the whole terrain, after generating or eroding it
+	bool UpdateBuffers(ID3D11DeviceContext* deviceContext);
+
+	// Binds the buffers with 16 or 32 bit indices, whichever initBuffers built
+	// Drawing getIndexCount() indices from the start still draws every chunk
+	void sendData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLOGY top = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	// Finds the chunks inside the frustum of a world * view * projection matrix, stored row by row as XMFLOAT4X4 does
+	// Returns how many there are
+	int CullChunks(const float* worldViewProjection);
+
+	// See TerrainChunks::SelectLevels, the camera is in the mesh's own space
+	int SelectChunkLevels(float cameraX, float cameraY, float cameraZ, float viewportHeight, float fieldOfView, float maxScreenError);
+
+	// Draws the chunks the last CullChunks found at the levels SelectChunkLevels last picked, after sendData and with the
+	// shaders already set, in place of a single DrawIndexed over the whole terrain
+	void DrawVisibleChunks(ID3D11DeviceContext* deviceContext);
+
+	const TerrainChunks& GetChunks() const;
+
 	bool CalculateNormals();
 
 private:
 
-	// Function for depositing sediment from the thermal erosion algorithm
-	float DepositSediment(float c, float maxDiff, float talus, float distance, float totalDiff);
+	HeightField heightField;
+	DXGI_FORMAT indexFormat;
 
-	int resolution;
-	HeightMapType* heightMap;
+	// CPU copy of the vertex buffer, kept between updates so only the changed chunks need writing
+	TerrainChunks chunks;
+	TerrainVertex* stagingVertices;
+	int bufferResolution;
 
-	// Pointers to the noise generation objects
-	ImprovedNoise* perlinNoiseGen;
-	SimplexNoise* simplexNoiseGen;
+	// Chunks the last CullChunks found
+	int* visibleChunks;
+	int visibleCount;
 
 };
 
@@ -0,0 +1,172 @@
+#include "ThreadPool.h"
+
+
+
+ThreadPool::ThreadPool(int threadCount)
+	: task(0), count(0), blockSize(1), blockCount(0), generation(0), stopping(false), nextBlock(0), activeWorkers(0)
+{
+
+	if (threadCount <= 0)
+	{
+
+		threadCount = (int)std::thread::hardware_concurrency();
+
+	}
+
+	// The calling thread takes part in every job, so only start the rest
+	for (int i = 1; i < threadCount; i++)
+	{
+
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+
+	}
+
+}
+
+ThreadPool::~ThreadPool()
+{
+
+	{
+
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+
+	}
+
+	wake.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+
+		workers[i].join();
+
+	}
+
+}
+
+int ThreadPool::GetThreadCount() const
+{
+
+	return (int)workers.size() + 1;
+
+}
+
+void ThreadPool::ParallelFor(int lcount, int lblockSize, const std::function<void(int, int)>& ltask)
+{
+
+	if (lcount <= 0)
+	{
+
+		return;
+
+	}
+
+	if (lblockSize < 1)
+	{
+
+		lblockSize = 1;
+
+	}
+
+	// Run small jobs, and every job on a single thread pool, without waking anyone
+	if (workers.empty() || lcount <= lblockSize)
+	{
+
+		for (int begin = 0; begin < lcount; begin += lblockSize)
+		{
+
+			ltask(begin, begin + lblockSize < lcount ? begin + lblockSize : lcount);
+
+		}
+
+		return;
+
+	}
+
+	{
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		task = &ltask;
+		count = lcount;
+		blockSize = lblockSize;
+		blockCount = (lcount + lblockSize - 1) / lblockSize;
+		nextBlock = 0;
+		generation++;
+
+	}
+
+	wake.notify_all();
+
+	RunBlocks();
+
+	// Every block has been handed out, wait for the workers still finishing theirs
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this] { return activeWorkers == 0; });
+
+	task = 0;
+
+}
+
+void ThreadPool::WorkerLoop()
+{
+
+	unsigned int seenGeneration = 0;
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (;;)
+	{
+
+		wake.wait(lock, [&] { return stopping || (generation != seenGeneration && task != 0); });
+
+		if (stopping)
+		{
+
+			return;
+
+		}
+
+		seenGeneration = generation;
+		activeWorkers++;
+
+		lock.unlock();
+		RunBlocks();
+		lock.lock();
+
+		activeWorkers--;
+
+		if (activeWorkers == 0)
+		{
+
+			finished.notify_all();
+
+		}
+
+	}
+
+}
+
+void ThreadPool::RunBlocks()
+{
+
+	for (;;)
+	{
+
+		int block = nextBlock.fetch_add(1);
+
+		if (block >= blockCount)
+		{
+
+			return;
+
+		}
+
+		int begin = block * blockSize;
+		int end = begin + blockSize < count ? begin + blockSize : count;
+
+		(*task)(begin, end);
+
+	}
+
+}
@@ -0,0 +1,56 @@
+// ThreadPool.h
+// Small persistent pool of worker threads for splitting loops over the terrain into blocks.
+// The calling thread works through blocks alongside the workers, so a pool of n threads keeps n workers minus one asleep
+// between jobs. Which thread runs which block is not fixed, so tasks must only write to the part of the output
+// their block owns for the result to be independent of the thread count.
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+
+public:
+
+	// threadCount includes the calling thread, 0 uses every hardware thread
+	explicit ThreadPool(int threadCount = 0);
+	~ThreadPool();
+
+	int GetThreadCount() const;
+
+	// Calls task(begin, end) for consecutive blocks of blockSize items covering [0, count), and returns once all of them are done
+	// Only one job runs at a time, so this must not be called from inside a task
+	void ParallelFor(int count, int blockSize, const std::function<void(int, int)>& task);
+
+private:
+
+	void WorkerLoop();
+	void RunBlocks();
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake;				// Signalled when a job is posted or the pool is shutting down
+	std::condition_variable finished;			// Signalled when a worker leaves a job
+
+	// Current job, only changed while no worker is running it
+	const std::function<void(int, int)>* task;
+	int count;
+	int blockSize;
+	int blockCount;
+	unsigned int generation;					// Bumped for every job so sleeping workers can tell a new one has arrived
+	bool stopping;
+
+	std::atomic<int> nextBlock;					// Next block to hand out
+	int activeWorkers;							// Workers currently taking blocks from the job
+
+	// Owns its threads, so copying isn't allowed
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+};
@@ -0,0 +1,371 @@
+// ChunkTests.cpp
+// Checks TerrainChunks' dirty tracking, frustum culling and index layout on a heightfield, without a GPU. Returns non-zero
+// if any check fails, so it can run under CTest.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "ImprovedNoise.h"
+#include "SimplexNoise.h"
+#include "TerrainChunks.h"
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what)
+{
+
+	if (!condition)
+	{
+
+		printf("FAILED: %s\n", what);
+		failures++;
+
+	}
+
+}
+
+// Builds every chunk, which leaves none of them dirty
+static void BuildAllChunks(TerrainChunks& chunks, const HeightField& field, TerrainVertex* vertices)
+{
+
+	for (int c = 0; c < chunks.GetChunkCount(); c++)
+	{
+
+		chunks.BuildChunk(field, c, vertices);
+
+	}
+
+}
+
+// The chunk along x and z at the given place in the layout
+static const TerrainChunk& ChunkAt(const TerrainChunks& chunks, int x, int z)
+{
+
+	int chunksX = (int)std::sqrt((double)chunks.GetChunkCount());
+
+	return chunks.GetChunk((chunksX * z) + x);
+
+}
+
+// Whether a chunk's grid points overlap rows [rowBegin, rowEnd) by columns [columnBegin, columnEnd) once the edit is
+// grown by the one vertex halo of the normals
+static bool Overlaps(const TerrainChunk& chunk, int resolution, int rowBegin, int rowEnd, int columnBegin, int columnEnd)
+{
+
+	rowBegin = std::max(rowBegin - 1, 0);
+	rowEnd = std::min(rowEnd + 1, resolution);
+	columnBegin = std::max(columnBegin - 1, 0);
+	columnEnd = std::min(columnEnd + 1, resolution);
+
+	return chunk.rowBegin < rowEnd && rowBegin < chunk.rowEnd && chunk.columnBegin < columnEnd && columnBegin < chunk.columnEnd;
+
+}
+
+static void TestMarkDirty(const HeightField& field)
+{
+
+	int resolution = field.GetResolution();
+
+	TerrainChunks chunks;
+	chunks.Layout(resolution, 64);
+	TerrainVertex* vertices = new TerrainVertex[chunks.GetVertexCount()];
+
+	// Column 64 is the last column of the first chunks and the first of the next, so both need rebuilding
+	BuildAllChunks(chunks, field, vertices);
+	chunks.MarkDirty(100, 101, 64, 65);
+
+	Check(ChunkAt(chunks, 0, 1).dirty && ChunkAt(chunks, 1, 1).dirty, "an edit on a chunk edge marks the chunks either side");
+	Check(!ChunkAt(chunks, 2, 1).dirty && !ChunkAt(chunks, 0, 0).dirty && !ChunkAt(chunks, 0, 2).dirty,
+		"an edit on a chunk edge leaves the chunks further away clean");
+
+	// Column 65 is inside the second chunks, but the normals at column 64 change with it
+	BuildAllChunks(chunks, field, vertices);
+	chunks.MarkDirty(100, 101, 65, 66);
+
+	Check(ChunkAt(chunks, 0, 1).dirty, "the normal halo of an edit marks the chunk beside it");
+	Check(ChunkAt(chunks, 1, 1).dirty, "an edit marks the chunk it's in");
+
+	// And an edit two columns short of the edge doesn't reach the next chunks
+	BuildAllChunks(chunks, field, vertices);
+	chunks.MarkDirty(100, 101, 61, 62);
+
+	Check(ChunkAt(chunks, 0, 1).dirty && !ChunkAt(chunks, 1, 1).dirty, "an edit away from the edge marks only its own chunk");
+
+	// Every edit marks exactly the chunks whose grid points it or its halo touches
+	const int edits[][4] =
+	{
+		{ 0, 1, 0, 1 }, { 63, 64, 63, 64 }, { 64, 65, 64, 65 }, { 127, 129, 0, resolution }, { 10, 200, 190, 191 },
+		{ resolution - 1, resolution, resolution - 1, resolution }, { 0, resolution, 0, resolution }
+	};
+
+	for (size_t e = 0; e < sizeof(edits) / sizeof(edits[0]); e++)
+	{
+
+		BuildAllChunks(chunks, field, vertices);
+		chunks.MarkDirty(edits[e][0], edits[e][1], edits[e][2], edits[e][3]);
+
+		for (int c = 0; c < chunks.GetChunkCount(); c++)
+		{
+
+			const TerrainChunk& chunk = chunks.GetChunk(c);
+
+			Check(chunk.dirty == Overlaps(chunk, resolution, edits[e][0], edits[e][1], edits[e][2], edits[e][3]),
+				"MarkDirty marks exactly the chunks the edit touches");
+
+		}
+
+	}
+
+	delete[] vertices;
+
+}
+
+// a * b for 4x4 matrices stored row by row
+static void Multiply(const float* a, const float* b, float* result)
+{
+
+	for (int r = 0; r < 4; r++)
+	{
+
+		for (int c = 0; c < 4; c++)
+		{
+
+			result[(4 * r) + c] = 0.0f;
+
+			for (int k = 0; k < 4; k++)
+			{
+
+				result[(4 * r) + c] += a[(4 * r) + k] * b[(4 * k) + c];
+
+			}
+
+		}
+
+	}
+
+}
+
+// Whether the point is inside the view volume of the row vector matrix, with depth from 0 to 1
+static bool InsideClip(const float* matrix, float x, float y, float z)
+{
+
+	float clip[4];
+
+	for (int c = 0; c < 4; c++)
+	{
+
+		clip[c] = (x * matrix[c]) + (y * matrix[4 + c]) + (z * matrix[8 + c]) + matrix[12 + c];
+
+	}
+
+	float w = clip[3];
+
+	return clip[0] >= -w && clip[0] <= w && clip[1] >= -w && clip[1] <= w && clip[2] >= 0.0f && clip[2] <= w;
+
+}
+
+static void TestCullChunks(const HeightField& field)
+{
+
+	TerrainChunks chunks;
+	chunks.Layout(field.GetResolution(), 32);
+	TerrainVertex* vertices = new TerrainVertex[chunks.GetVertexCount()];
+	BuildAllChunks(chunks, field, vertices);
+
+	// A camera in the middle of the map looking along +x, laid out as DirectXMath's XMMatrixLookAtLH and
+	// XMMatrixPerspectiveFovLH would. It sits halfway up the chunk under it, so that chunk is partly in view
+	float eyeX = 50.0f;
+	float eyeY = 0.0f;
+	float eyeZ = 50.0f;
+
+	for (int c = 0; c < chunks.GetChunkCount(); c++)
+	{
+
+		const TerrainChunk& chunk = chunks.GetChunk(c);
+
+		if (chunk.minX < eyeX && chunk.maxX > eyeX && chunk.minZ < eyeZ && chunk.maxZ > eyeZ)
+		{
+
+			eyeY = 0.5f * (chunk.minY + chunk.maxY);
+
+		}
+
+	}
+
+	float view[16] =
+	{
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		-1.0f, 0.0f, 0.0f, 0.0f,
+		eyeZ, -eyeY, -eyeX, 1.0f
+	};
+
+	float nearZ = 0.1f;
+	float farZ = 1000.0f;
+	float yScale = 1.0f / std::tan(0.5f * 1.0471976f);
+	float depth = farZ / (farZ - nearZ);
+
+	float projection[16] =
+	{
+		yScale, 0.0f, 0.0f, 0.0f,
+		0.0f, yScale, 0.0f, 0.0f,
+		0.0f, 0.0f, depth, 1.0f,
+		0.0f, 0.0f, -nearZ * depth, 0.0f
+	};
+
+	float viewProjection[16];
+	Multiply(view, projection, viewProjection);
+
+	int* visible = new int[chunks.GetChunkCount()];
+	int visibleCount = chunks.CullChunks(ExtractTerrainFrustum(viewProjection), visible);
+
+	bool* isVisible = new bool[chunks.GetChunkCount()];
+	std::fill(isVisible, isVisible + chunks.GetChunkCount(), false);
+
+	for (int v = 0; v < visibleCount; v++)
+	{
+
+		isVisible[visible[v]] = true;
+
+	}
+
+	Check(visibleCount > 0 && visibleCount < chunks.GetChunkCount(), "the camera sees some chunks but not all of them");
+
+	const int samples = 8;
+
+	for (int c = 0; c < chunks.GetChunkCount(); c++)
+	{
+
+		const TerrainChunk& chunk = chunks.GetChunk(c);
+
+		// Behind the camera
+		if (chunk.maxX < eyeX)
+		{
+
+			Check(!isVisible[c], "chunks behind the camera are culled");
+
+		}
+
+		// Any point of the bounding box in view, including those of boxes straddling a plane, keeps the chunk
+		bool seen = false;
+
+		for (int k = 0; k <= samples && !seen; k++)
+		{
+
+			for (int j = 0; j <= samples && !seen; j++)
+			{
+
+				for (int i = 0; i <= samples && !seen; i++)
+				{
+
+					float x = chunk.minX + ((chunk.maxX - chunk.minX) * i / samples);
+					float y = chunk.minY + ((chunk.maxY - chunk.minY) * j / samples);
+					float z = chunk.minZ + ((chunk.maxZ - chunk.minZ) * k / samples);
+
+					seen = InsideClip(viewProjection, x, y, z);
+
+				}
+
+			}
+
+		}
+
+		if (seen)
+		{
+
+			Check(isVisible[c], "no chunk with part of it in view is culled");
+
+		}
+
+		// The chunks under the camera reach behind it and in front of it
+		if (chunk.minX < eyeX && chunk.maxX > eyeX && chunk.minZ < eyeZ && chunk.maxZ > eyeZ)
+		{
+
+			Check(isVisible[c], "a chunk straddling the near plane is kept");
+
+		}
+
+	}
+
+	delete[] visible;
+	delete[] isVisible;
+	delete[] vertices;
+
+}
+
+template <typename Index>
+static void CheckLevelZeroIndices(const TerrainChunks& chunks, const Index* indices)
+{
+
+	for (int c = 0; c < chunks.GetChunkCount(); c++)
+	{
+
+		const TerrainChunk& chunk = chunks.GetChunk(c);
+		bool inside = true;
+
+		for (int k = chunk.levelIndexStart[0]; k < chunk.levelIndexStart[0] + chunk.levelIndexCount[0]; k++)
+		{
+
+			inside = inside && (int)indices[k] >= chunk.vertexStart && (int)indices[k] < chunk.vertexStart + chunk.vertexCount;
+
+		}
+
+		Check(inside, "level 0 of a chunk only uses the chunk's own vertices");
+
+	}
+
+}
+
+static void TestBuildIndices(int resolution)
+{
+
+	TerrainChunks chunks;
+	chunks.Layout(resolution, 64);
+
+	Check(chunks.GetChunk(0).levelIndexStart[0] == 0, "level 0 starts the index buffer");
+
+	unsigned int* indices = new unsigned int[chunks.GetIndexCount()];
+	chunks.BuildIndices(indices);
+	CheckLevelZeroIndices(chunks, indices);
+	delete[] indices;
+
+	if (chunks.GetIndexSize() == 2)
+	{
+
+		unsigned short* shortIndices = new unsigned short[chunks.GetIndexCount()];
+		chunks.BuildIndices(shortIndices);
+		CheckLevelZeroIndices(chunks, shortIndices);
+		delete[] shortIndices;
+
+	}
+
+}
+
+int main()
+{
+
+	ImprovedNoise perlin;
+	SimplexNoise simplex;
+
+	HeightField field(&perlin, &simplex, 257);
+	field.GenerateHeightMap(0.0f, 0.0f, 0.02f, 20.0f, false, false, 8, 0.5f, 0.0f);
+	field.CalculateNormals();
+
+	TestMarkDirty(field);
+	TestCullChunks(field);
+
+	// Whole chunks, and chunks with a row and column left over
+	TestBuildIndices(129);
+	TestBuildIndices(200);
+	TestBuildIndices(257);
+
+	if (failures == 0)
+	{
+
+		printf("All chunk tests passed\n");
+
+	}
+
+	return failures == 0 ? 0 : 1;
+
+}
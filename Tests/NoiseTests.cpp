@@ -0,0 +1,426 @@
+// NoiseTests.cpp
+// Checks the single precision noise generators (ImprovedNoiseF and SimplexNoiseF) and every batched kernel the CPU supports
+// against the double precision reference over random points at a range of coordinate magnitudes up to 65536, and that the
+// dual 2D noise matches two single plane calls bit for bit. Returns non-zero if any result is further from the reference
+// than the bounds below, so it can run under CTest.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "ImprovedNoise.h"
+#include "SimplexNoise.h"
+#include "NoiseBatch.h"
+
+// Largest difference allowed between the float and double generators
+static const double NOISE_FLOAT_TOLERANCE = 2.5e-6;
+
+// 3D simplex noise is slightly discontinuous on the boundaries between simplices, so points close enough to one that
+// rounding can pick the other simplex are allowed up to NOISE_BATCH_SIMPLEX_SEAM_TOLERANCE instead
+static const double SIMPLEX_BOUNDARY_DISTANCE = 1e-3;
+
+// Random points per coordinate range and noise function
+static const int POINTS_PER_RANGE = 200000;
+
+// Points in each batch, not a multiple of any kernel's width so the tails get run too
+static const int BATCH_POINTS = 100003;
+
+// Planes the 2D batches are run on, the dual ones as fBm uses them
+static const int BATCH_PLANE = 3;
+static const int BATCH_PLANE_A = 0;
+static const int BATCH_PLANE_B = 150;
+
+static const float COORDINATE_RANGES[] = { 1.0f, 16.0f, 256.0f, 4096.0f, 65536.0f };
+
+struct ErrorResult
+{
+
+	const char* generator;
+	const char* name;
+	float range;
+	double maxError;
+	double tolerance;
+
+};
+
+static bool Report(const ErrorResult& result)
+{
+
+	bool passed = result.maxError <= result.tolerance;
+
+	printf("%-6s %-15s |coord| <= %-7g max error %.3g (tolerance %.3g) %s\n", result.generator, result.name, result.range,
+		result.maxError, result.tolerance, passed ? "ok" : "FAILED");
+
+	return passed;
+
+}
+
+// How close the point is to the boundary between two of the simplices its skewed cell is split into, or to the cell's faces
+static double SimplexBoundaryDistance(double x, double y, double z)
+{
+
+	double s = (x + y + z) / 3.0;
+	double sx = x + s;
+	double sy = y + s;
+	double sz = z + s;
+
+	double t = (std::floor(sx) + std::floor(sy) + std::floor(sz)) / 6.0;
+	double x0 = x - (std::floor(sx) - t);
+	double y0 = y - (std::floor(sy) - t);
+	double z0 = z - (std::floor(sz) - t);
+
+	double distance = std::min(std::fabs(x0 - y0), std::min(std::fabs(y0 - z0), std::fabs(x0 - z0)));
+
+	// The cell's own faces are simplex boundaries too
+	double faces[] = { sx, sy, sz };
+
+	for (int k = 0; k < 3; k++)
+	{
+
+		double fraction = faces[k] - std::floor(faces[k]);
+		distance = std::min(distance, std::min(fraction, 1.0 - fraction));
+
+	}
+
+	return distance;
+
+}
+
+// The scalar float generators against the double ones, point by point
+static bool TestFloatGenerators()
+{
+
+	ImprovedNoise perlin;
+	ImprovedNoiseF perlinF;
+	SimplexNoise simplex;
+	SimplexNoiseF simplexF;
+
+	std::mt19937 random(12345);
+	bool passed = true;
+
+	for (float range : COORDINATE_RANGES)
+	{
+
+		std::uniform_real_distribution<float> coordinate(-range, range);
+
+		ErrorResult perlin3D = { "float", "perlin3D", range, 0.0, NOISE_FLOAT_TOLERANCE };
+		ErrorResult perlin2D = { "float", "perlin2D", range, 0.0, NOISE_FLOAT_TOLERANCE };
+		ErrorResult simplex2D = { "float", "simplex2D", range, 0.0, NOISE_FLOAT_TOLERANCE };
+		ErrorResult simplex3D = { "float", "simplex3D", range, 0.0, NOISE_FLOAT_TOLERANCE };
+		ErrorResult simplex3DSeam = { "float", "simplex3D seam", range, 0.0, NOISE_BATCH_SIMPLEX_SEAM_TOLERANCE };
+
+		for (int n = 0; n < POINTS_PER_RANGE; n++)
+		{
+
+			// The float coordinates are exactly representable as doubles, so both generators see the same point
+			float x = coordinate(random);
+			float y = coordinate(random);
+			float z = coordinate(random);
+
+			perlin3D.maxError = std::max(perlin3D.maxError, std::fabs(perlinF.noise(x, y, z) - perlin.noise(x, y, z)));
+			perlin2D.maxError = std::max(perlin2D.maxError, std::fabs(perlinF.noise2D(x, z, 0) - perlin.noise2D(x, z, 0)));
+			simplex2D.maxError = std::max(simplex2D.maxError, std::fabs(simplexF.noise2D(x, z, 0) - simplex.noise2D(x, z, 0)));
+
+			double error = std::fabs(simplexF.noise(x, y, z) - simplex.noise(x, y, z));
+
+			if (SimplexBoundaryDistance(x, y, z) < SIMPLEX_BOUNDARY_DISTANCE)
+			{
+
+				simplex3DSeam.maxError = std::max(simplex3DSeam.maxError, error);
+
+			}
+			else
+			{
+
+				simplex3D.maxError = std::max(simplex3D.maxError, error);
+
+			}
+
+		}
+
+		passed = Report(perlin3D) && passed;
+		passed = Report(perlin2D) && passed;
+		passed = Report(simplex2D) && passed;
+		passed = Report(simplex3D) && passed;
+		passed = Report(simplex3DSeam) && passed;
+
+	}
+
+	return passed;
+
+}
+
+// Whether the scalar dual 2D noise gives the same bits as two single plane calls over random points
+template <typename Generator, typename T>
+static bool DualMatchesSingle(Generator& generator, const char* name)
+{
+
+	std::mt19937 random(777);
+	int mismatches = 0;
+
+	for (float range : COORDINATE_RANGES)
+	{
+
+		std::uniform_real_distribution<float> coordinate(-range, range);
+
+		for (int n = 0; n < POINTS_PER_RANGE; n++)
+		{
+
+			T x = coordinate(random);
+			T z = coordinate(random);
+
+			T dualA, dualB;
+			generator.noise2DDual(x, z, BATCH_PLANE_A, BATCH_PLANE_B, dualA, dualB);
+
+			T singleA = generator.noise2D(x, z, BATCH_PLANE_A);
+			T singleB = generator.noise2D(x, z, BATCH_PLANE_B);
+
+			if (std::memcmp(&dualA, &singleA, sizeof(T)) != 0 || std::memcmp(&dualB, &singleB, sizeof(T)) != 0)
+			{
+
+				mismatches++;
+
+			}
+
+		}
+
+	}
+
+	printf("%-22s dual matches two noise2D calls bit for bit: %s (%d mismatches)\n", name, mismatches == 0 ? "ok" : "FAILED",
+		mismatches);
+
+	return mismatches == 0;
+
+}
+
+static bool TestScalarDuals()
+{
+
+	ImprovedNoise perlin;
+	ImprovedNoiseF perlinF;
+	SimplexNoise simplex;
+	SimplexNoiseF simplexF;
+
+	bool passed = DualMatchesSingle<ImprovedNoise, double>(perlin, "perlin double");
+	passed = DualMatchesSingle<ImprovedNoiseF, float>(perlinF, "perlin float") && passed;
+	passed = DualMatchesSingle<SimplexNoise, double>(simplex, "simplex double") && passed;
+	passed = DualMatchesSingle<SimplexNoiseF, float>(simplexF, "simplex float") && passed;
+
+	return passed;
+
+}
+
+// Largest difference between a batch and its reference, split between 3D simplex boundaries and everywhere else when
+// boundary is given
+static void CompareBatch(const float* batch, const double* reference, const bool* boundary, ErrorResult& result,
+	ErrorResult* seam)
+{
+
+	for (int n = 0; n < BATCH_POINTS; n++)
+	{
+
+		double error = std::fabs(batch[n] - reference[n]);
+
+		if (boundary != 0 && boundary[n])
+		{
+
+			seam->maxError = std::max(seam->maxError, error);
+
+		}
+		else
+		{
+
+			result.maxError = std::max(result.maxError, error);
+
+		}
+
+	}
+
+}
+
+// Whether two batches are the same bit for bit
+static bool SameBatch(const float* a, const float* b)
+{
+
+	return std::memcmp(a, b, sizeof(float) * BATCH_POINTS) == 0;
+
+}
+
+// Every batched kernel the CPU supports against the double generators, and against the scalar kernel, which every path is
+// meant to match exactly
+static bool TestBatchKernels()
+{
+
+	ImprovedNoise perlin;
+	SimplexNoise simplex;
+
+	const NoiseInstructionSet instructionSets[] = { NOISE_SCALAR, NOISE_SSE41, NOISE_AVX2 };
+	const char* instructionSetNames[] = { "scalar", "sse41", "avx2" };
+
+	// Batch outputs, the scalar kernel's kept to compare the others with
+	const int outputCount = 8;
+	float* outputs[outputCount];
+	float* scalarOutputs[outputCount];
+
+	for (int k = 0; k < outputCount; k++)
+	{
+
+		outputs[k] = new float[BATCH_POINTS];
+		scalarOutputs[k] = new float[BATCH_POINTS];
+
+	}
+
+	float* x = new float[BATCH_POINTS];
+	float* y = new float[BATCH_POINTS];
+	float* z = new float[BATCH_POINTS];
+	// The dual simplex batch is run on plane 3 and plane 150, so its first output shares the single plane batch's reference
+	const int referenceCount = 7;
+	double* references[referenceCount];
+
+	for (int k = 0; k < referenceCount; k++)
+	{
+
+		references[k] = new double[BATCH_POINTS];
+
+	}
+
+	bool* boundary = new bool[BATCH_POINTS];
+
+	std::mt19937 random(54321);
+	bool passed = true;
+
+	for (float range : COORDINATE_RANGES)
+	{
+
+		std::uniform_real_distribution<float> coordinate(-range, range);
+
+		for (int n = 0; n < BATCH_POINTS; n++)
+		{
+
+			x[n] = coordinate(random);
+			y[n] = coordinate(random);
+			z[n] = coordinate(random);
+
+			references[0][n] = perlin.noise(x[n], y[n], z[n]);
+			references[1][n] = perlin.noise2D(x[n], z[n], BATCH_PLANE);
+			references[2][n] = perlin.noise2D(x[n], z[n], BATCH_PLANE_A);
+			references[3][n] = perlin.noise2D(x[n], z[n], BATCH_PLANE_B);
+			references[4][n] = simplex.noise(x[n], y[n], z[n]);
+			references[5][n] = simplex.noise2D(x[n], z[n], BATCH_PLANE);
+			references[6][n] = simplex.noise2D(x[n], z[n], BATCH_PLANE_B);
+			boundary[n] = SimplexBoundaryDistance(x[n], y[n], z[n]) < SIMPLEX_BOUNDARY_DISTANCE;
+
+		}
+
+		for (int s = 0; s < 3; s++)
+		{
+
+			// Sets the CPU doesn't support fall back to another, which has been tested already
+			SetNoiseInstructionSet(instructionSets[s]);
+
+			if (GetNoiseInstructionSet() != instructionSets[s])
+			{
+
+				continue;
+
+			}
+
+			perlin.noise(x, y, z, outputs[0], BATCH_POINTS);
+			perlin.noise2D(x, z, BATCH_PLANE, outputs[1], BATCH_POINTS);
+			perlin.noise2DDual(x, z, BATCH_PLANE_A, BATCH_PLANE_B, outputs[2], outputs[3], BATCH_POINTS);
+			simplex.noise(x, y, z, outputs[4], BATCH_POINTS);
+			simplex.noise2D(x, z, BATCH_PLANE, outputs[5], BATCH_POINTS);
+			simplex.noise2DDual(x, z, BATCH_PLANE, BATCH_PLANE_B, outputs[7], outputs[6], BATCH_POINTS);
+
+			const char* name = instructionSetNames[s];
+
+			ErrorResult perlin3D = { name, "perlin3D", range, 0.0, NOISE_BATCH_TOLERANCE };
+			ErrorResult perlin2D = { name, "perlin2D", range, 0.0, NOISE_BATCH_TOLERANCE };
+			ErrorResult perlinDual = { name, "perlin2D dual", range, 0.0, NOISE_BATCH_TOLERANCE };
+			ErrorResult simplex3D = { name, "simplex3D", range, 0.0, NOISE_BATCH_TOLERANCE };
+			ErrorResult simplex3DSeam = { name, "simplex3D seam", range, 0.0, NOISE_BATCH_SIMPLEX_SEAM_TOLERANCE };
+			ErrorResult simplex2D = { name, "simplex2D", range, 0.0, NOISE_BATCH_TOLERANCE };
+			ErrorResult simplexDual = { name, "simplex2D dual", range, 0.0, NOISE_BATCH_TOLERANCE };
+
+			CompareBatch(outputs[0], references[0], 0, perlin3D, 0);
+			CompareBatch(outputs[1], references[1], 0, perlin2D, 0);
+			CompareBatch(outputs[2], references[2], 0, perlinDual, 0);
+			CompareBatch(outputs[3], references[3], 0, perlinDual, 0);
+			CompareBatch(outputs[4], references[4], boundary, simplex3D, &simplex3DSeam);
+			CompareBatch(outputs[5], references[5], 0, simplex2D, 0);
+			CompareBatch(outputs[7], references[5], 0, simplexDual, 0);
+			CompareBatch(outputs[6], references[6], 0, simplexDual, 0);
+
+			passed = Report(perlin3D) && passed;
+			passed = Report(perlin2D) && passed;
+			passed = Report(perlinDual) && passed;
+			passed = Report(simplex3D) && passed;
+			passed = Report(simplex3DSeam) && passed;
+			passed = Report(simplex2D) && passed;
+			passed = Report(simplexDual) && passed;
+
+			bool sameAsScalar = true;
+
+			for (int k = 0; k < outputCount; k++)
+			{
+
+				if (instructionSets[s] == NOISE_SCALAR)
+				{
+
+					std::memcpy(scalarOutputs[k], outputs[k], sizeof(float) * BATCH_POINTS);
+
+				}
+				else
+				{
+
+					sameAsScalar = sameAsScalar && SameBatch(outputs[k], scalarOutputs[k]);
+
+				}
+
+			}
+
+			printf("%-6s matches the scalar kernel bit for bit: %s\n", name, sameAsScalar ? "ok" : "FAILED");
+			passed = sameAsScalar && passed;
+
+		}
+
+	}
+
+	// Back to the best set the CPU has
+	SetNoiseInstructionSet(NOISE_AVX2);
+
+	for (int k = 0; k < outputCount; k++)
+	{
+
+		delete[] outputs[k];
+		delete[] scalarOutputs[k];
+
+	}
+
+	for (int k = 0; k < referenceCount; k++)
+	{
+
+		delete[] references[k];
+
+	}
+
+	delete[] x;
+	delete[] y;
+	delete[] z;
+	delete[] boundary;
+
+	return passed;
+
+}
+
+int main()
+{
+
+	bool passed = TestFloatGenerators();
+	passed = TestScalarDuals() && passed;
+	passed = TestBatchKernels() && passed;
+
+	return passed ? 0 : 1;
+
+}
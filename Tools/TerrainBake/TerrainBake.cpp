@@ -0,0 +1,643 @@
+// TerrainBake.cpp
+// Command-line batch generator for bake jobs. Reads one parameter file per job, builds the terrain with HeightField
+// and writes the heightmap out, without needing a GPU or DirectX.
+//
+// Usage: TerrainBake [--threads N] job.txt [job2.txt ...]
+//
+// A parameter file holds one "key = value" pair per line, lines starting with # are comments. Any key left out keeps the
+// default shown here. Stages run in the order generation, smoothing, thermal erosion, hydraulic erosion, and a stage is
+// skipped while its passes, iterations or drops are 0.
+//
+//   output = terrain.r32           file to write, required
+//   format = r32                   r32 (raw 32 bit floats), r16 (raw 16 bit) or pgm (16 bit greyscale)
+//   resolution = 512               vertices along each side
+//   seed = 1                       seeds the hydraulic erosion droplets
+//   threads = 0                    0 uses every hardware thread, overridden by --threads
+//   boundary = wall                how smoothing and erosion treat the map edges: wall, clamp, mirror or wrap
+//
+//   offsetX = 0, offsetZ = 0, frequency = 0.02, amplitude = 20, octaves = 8, persistence = 0.5, offsetY = 0
+//   ridged = 0, simplex = 0        1 to turn on
+//
+//   smoothingPasses = 0, smoothingWeight = 0.5, smoothingUpper = 1000, smoothingLower = -1000
+//   smoothingFilter = moore        moore (neighbour average), jacobi (double buffered neighbour average), box or gaussian
+//   smoothingRadius = 1            window radius of the box and gaussian filters
+//   thermalIterations = 0, thermalEngine = scatter   scatter (original), gather (parallel and mass-conserving) or pyramid
+//                                  (gather run coarse-to-fine, thermalIterations at every level)
+//   thermalLevels = 4              pyramid only, number of levels including the full resolution
+//   thermalTolerance               gather and pyramid, stops once no height changes by more than this in an iteration
+//   hydraulicDrops = 0, hydraulicIterations = 30, carryingCapacity = 0.5, depositionSpeed = 0.1, hydraulicPersistence = 0.9
+//   hydraulicEngine = serial       serial (original, droplets placed with rand()) or parallel (droplets run on every thread)
+//   pipeIterations = 0, rainfall = 0.01, evaporation = 0.5   grid-based pipe model erosion, using carryingCapacity and
+//                                  depositionSpeed too. Runs after the droplets when hydraulicDrops is set as well
+//
+//   heightMin, heightMax           range mapped onto the 16 bit formats, either one left out is the terrain's own lowest or
+//                                  highest height
+//   meshError = 0                  builds an adaptive mesh of the baked terrain within this vertical error and reports its
+//                                  size and the error it reached, skipped while 0
+//
+// Build with CMake from the repository root (see README.md), or directly, e.g. with GCC or Clang:
+//   g++ -O2 -std=c++11 -pthread -ICode Tools/TerrainBake/TerrainBake.cpp Code/HeightField.cpp Code/HeightMapIO.cpp
+//     Code/TerrainGeometry.cpp Code/TerrainAdaptiveMesh.cpp Code/ThreadPool.cpp Code/ImprovedNoise.cpp Code/SimplexNoise.cpp
+//     Code/NoiseBatch.cpp Code/NoiseSSE41.cpp Code/NoiseAVX2.cpp -o TerrainBake
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "HeightField.h"
+#include "HeightMapIO.h"
+#include "TerrainAdaptiveMesh.h"
+
+struct BakeJob
+{
+
+	std::string output;
+	std::string format;
+	int resolution;
+	unsigned int seed;
+	int threads;
+	BoundaryMode boundary;
+
+	float offsetX, offsetZ, frequency, amplitude, persistence, offsetY;
+	int octaves;
+	bool ridged, simplex;
+
+	int smoothingPasses, smoothingRadius;
+	std::string smoothingFilter;
+	float smoothingWeight, smoothingUpper, smoothingLower;
+
+	int thermalIterations, thermalLevels;
+	std::string thermalEngine;
+	float thermalTolerance;
+
+	int hydraulicDrops, hydraulicIterations;
+	float carryingCapacity, depositionSpeed, hydraulicPersistence;
+	std::string hydraulicEngine;
+
+	int pipeIterations;
+	float rainfall, evaporation;
+
+	bool heightMinSet, heightMaxSet;
+	float heightMin, heightMax;
+
+	float meshError;
+
+};
+
+static void SetDefaults(BakeJob& job)
+{
+
+	job.output = "";
+	job.format = "r32";
+	job.resolution = 512;
+	job.seed = 1;
+	job.threads = 0;
+	job.boundary = BOUNDARY_WALL;
+
+	job.offsetX = 0.0f;
+	job.offsetZ = 0.0f;
+	job.frequency = 0.02f;
+	job.amplitude = 20.0f;
+	job.persistence = 0.5f;
+	job.offsetY = 0.0f;
+	job.octaves = 8;
+	job.ridged = false;
+	job.simplex = false;
+
+	job.smoothingPasses = 0;
+	job.smoothingRadius = 1;
+	job.smoothingFilter = "moore";
+	job.smoothingWeight = 0.5f;
+	job.smoothingUpper = 1000.0f;
+	job.smoothingLower = -1000.0f;
+
+	job.thermalIterations = 0;
+	job.thermalLevels = 4;
+	job.thermalEngine = "scatter";
+	job.thermalTolerance = -1.0f;
+
+	job.hydraulicDrops = 0;
+	job.hydraulicIterations = 30;
+	job.carryingCapacity = 0.5f;
+	job.depositionSpeed = 0.1f;
+	job.hydraulicPersistence = 0.9f;
+	job.hydraulicEngine = "serial";
+
+	job.pipeIterations = 0;
+	job.rainfall = 0.01f;
+	job.evaporation = 0.5f;
+
+	job.heightMinSet = false;
+	job.heightMaxSet = false;
+	job.heightMin = 0.0f;
+	job.heightMax = 0.0f;
+
+	job.meshError = 0.0f;
+
+}
+
+// Removes spaces and tabs from both ends of the string
+static std::string Trim(const std::string& text)
+{
+
+	size_t begin = text.find_first_not_of(" \t\r\n");
+
+	if (begin == std::string::npos)
+	{
+
+		return "";
+
+	}
+
+	size_t end = text.find_last_not_of(" \t\r\n");
+
+	return text.substr(begin, end - begin + 1);
+
+}
+
+// Parses a number into value, false if the text isn't one
+static bool ParseFloat(const std::string& text, float& value)
+{
+
+	char* end;
+	value = strtof(text.c_str(), &end);
+
+	return end != text.c_str() && *end == '\0';
+
+}
+
+static bool ParseInt(const std::string& text, int& value)
+{
+
+	char* end;
+	value = (int)strtol(text.c_str(), &end, 10);
+
+	return end != text.c_str() && *end == '\0';
+
+}
+
+// Stores one key's value in the job, false if the key is unknown or the value is malformed
+static bool SetParameter(BakeJob& job, const std::string& key, const std::string& value)
+{
+
+	// Float parameters
+	struct FloatKey { const char* name; float* field; };
+	FloatKey floatKeys[] =
+	{
+		{ "offsetX", &job.offsetX }, { "offsetZ", &job.offsetZ }, { "frequency", &job.frequency },
+		{ "amplitude", &job.amplitude }, { "persistence", &job.persistence }, { "offsetY", &job.offsetY },
+		{ "smoothingWeight", &job.smoothingWeight }, { "smoothingUpper", &job.smoothingUpper },
+		{ "smoothingLower", &job.smoothingLower }, { "carryingCapacity", &job.carryingCapacity },
+		{ "depositionSpeed", &job.depositionSpeed }, { "hydraulicPersistence", &job.hydraulicPersistence },
+		{ "thermalTolerance", &job.thermalTolerance }, { "rainfall", &job.rainfall }, { "evaporation", &job.evaporation },
+		{ "meshError", &job.meshError }
+	};
+
+	for (size_t k = 0; k < sizeof(floatKeys) / sizeof(floatKeys[0]); k++)
+	{
+
+		if (key == floatKeys[k].name)
+		{
+
+			return ParseFloat(value, *floatKeys[k].field);
+
+		}
+
+	}
+
+	// Integer parameters
+	struct IntKey { const char* name; int* field; };
+	IntKey intKeys[] =
+	{
+		{ "resolution", &job.resolution }, { "threads", &job.threads }, { "octaves", &job.octaves },
+		{ "smoothingPasses", &job.smoothingPasses }, { "smoothingRadius", &job.smoothingRadius }, { "thermalIterations", &job.thermalIterations },
+		{ "thermalLevels", &job.thermalLevels }, { "hydraulicDrops", &job.hydraulicDrops }, { "hydraulicIterations", &job.hydraulicIterations },
+		{ "pipeIterations", &job.pipeIterations }
+	};
+
+	for (size_t k = 0; k < sizeof(intKeys) / sizeof(intKeys[0]); k++)
+	{
+
+		if (key == intKeys[k].name)
+		{
+
+			return ParseInt(value, *intKeys[k].field);
+
+		}
+
+	}
+
+	int flag;
+
+	if (key == "ridged" || key == "simplex")
+	{
+
+		if (!ParseInt(value, flag))
+		{
+
+			return false;
+
+		}
+
+		(key == "ridged" ? job.ridged : job.simplex) = flag != 0;
+		return true;
+
+	}
+
+	if (key == "seed")
+	{
+
+		if (!ParseInt(value, flag))
+		{
+
+			return false;
+
+		}
+
+		job.seed = (unsigned int)flag;
+		return true;
+
+	}
+
+	if (key == "heightMin")
+	{
+
+		job.heightMinSet = true;
+		return ParseFloat(value, job.heightMin);
+
+	}
+
+	if (key == "heightMax")
+	{
+
+		job.heightMaxSet = true;
+		return ParseFloat(value, job.heightMax);
+
+	}
+
+	if (key == "boundary")
+	{
+
+		const char* names[] = { "wall", "clamp", "mirror", "wrap" };
+		BoundaryMode modes[] = { BOUNDARY_WALL, BOUNDARY_CLAMP, BOUNDARY_MIRROR, BOUNDARY_WRAP };
+
+		for (int k = 0; k < 4; k++)
+		{
+
+			if (value == names[k])
+			{
+
+				job.boundary = modes[k];
+				return true;
+
+			}
+
+		}
+
+		return false;
+
+	}
+
+	if (key == "smoothingFilter")
+	{
+
+		job.smoothingFilter = value;
+		return value == "moore" || value == "jacobi" || value == "box" || value == "gaussian";
+
+	}
+
+	if (key == "thermalEngine")
+	{
+
+		job.thermalEngine = value;
+		return value == "scatter" || value == "gather" || value == "pyramid";
+
+	}
+
+	if (key == "hydraulicEngine")
+	{
+
+		job.hydraulicEngine = value;
+		return value == "serial" || value == "parallel";
+
+	}
+
+	if (key == "output")
+	{
+
+		job.output = value;
+		return true;
+
+	}
+
+	if (key == "format")
+	{
+
+		job.format = value;
+		return value == "r32" || value == "r16" || value == "pgm";
+
+	}
+
+	return false;
+
+}
+
+// Reads a parameter file into the job, reporting the first bad line
+static bool ReadJob(const char* path, BakeJob& job)
+{
+
+	FILE* file = fopen(path, "r");
+
+	if (file == 0)
+	{
+
+		fprintf(stderr, "%s: could not open file\n", path);
+		return false;
+
+	}
+
+	SetDefaults(job);
+
+	char buffer[1024];
+	int lineNumber = 0;
+	bool ok = true;
+
+	while (ok && fgets(buffer, sizeof(buffer), file) != 0)
+	{
+
+		lineNumber++;
+
+		std::string line = Trim(buffer);
+
+		if (line.empty() || line[0] == '#')
+		{
+
+			continue;
+
+		}
+
+		size_t equals = line.find('=');
+
+		if (equals == std::string::npos || !SetParameter(job, Trim(line.substr(0, equals)), Trim(line.substr(equals + 1))))
+		{
+
+			fprintf(stderr, "%s:%d: bad parameter \"%s\"\n", path, lineNumber, line.c_str());
+			ok = false;
+
+		}
+
+	}
+
+	fclose(file);
+
+	if (ok && job.output.empty())
+	{
+
+		fprintf(stderr, "%s: no output given\n", path);
+		ok = false;
+
+	}
+
+	if (ok && job.resolution < 2)
+	{
+
+		fprintf(stderr, "%s: resolution must be at least 2\n", path);
+		ok = false;
+
+	}
+
+	return ok;
+
+}
+
+// Builds the terrain for the job and writes it out
+static bool RunJob(const BakeJob& job, ImprovedNoise* perlin, SimplexNoise* simplex)
+{
+
+	double start = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	HeightField field(perlin, simplex, job.resolution);
+	field.SetThreadCount(job.threads);
+	field.SetBoundaryMode(job.boundary);
+
+	field.GenerateHeightMap(job.offsetX, job.offsetZ, job.frequency, job.amplitude, job.ridged, job.simplex,
+		job.octaves, job.persistence, job.offsetY);
+
+	if (job.smoothingFilter == "box" || job.smoothingFilter == "gaussian")
+	{
+
+		field.SeparableSmoothing(job.smoothingFilter == "box" ? SMOOTHING_BOX : SMOOTHING_GAUSSIAN, job.smoothingRadius,
+			job.smoothingPasses, job.smoothingWeight, job.smoothingUpper, job.smoothingLower);
+
+	}
+	else
+	{
+
+		field.SetSmoothingDoubleBuffered(job.smoothingFilter == "jacobi");
+
+		for (int pass = 0; pass < job.smoothingPasses; pass++)
+		{
+
+			field.SmoothingFunction(job.smoothingWeight, job.smoothingUpper, job.smoothingLower);
+
+		}
+
+	}
+
+	if (job.thermalIterations > 0)
+	{
+
+		if (job.thermalEngine == "gather" || job.thermalEngine == "pyramid")
+		{
+
+			// Only track the tiles that are still changing when asked to stop early
+			field.SetThermalErosionConvergence(job.thermalTolerance >= 0.0f, std::max(job.thermalTolerance, 0.0f));
+
+			if (job.thermalEngine == "pyramid")
+			{
+
+				field.PyramidThermalErosion(job.thermalIterations, job.thermalLevels);
+
+			}
+			else
+			{
+
+				field.ParallelThermalErosion(job.thermalIterations);
+
+			}
+
+			const HeightField::ThermalErosionStats& stats = field.GetThermalErosionStats();
+
+			printf("%s: thermal erosion ran %d iterations over %lld vertices\n", job.output.c_str(), stats.iterations,
+				stats.cellsProcessed);
+
+		}
+		else
+		{
+
+			field.ThermalErosion(job.thermalIterations);
+
+		}
+
+	}
+
+	if (job.hydraulicDrops > 0)
+	{
+
+		if (job.hydraulicEngine == "parallel")
+		{
+
+			field.ParallelHydraulicErosion(job.carryingCapacity, job.depositionSpeed, job.hydraulicIterations, job.hydraulicDrops,
+				job.hydraulicPersistence, job.seed);
+
+		}
+		else
+		{
+
+			srand(job.seed);
+			field.HydraulicErosion(job.carryingCapacity, job.depositionSpeed, job.hydraulicIterations, job.hydraulicDrops,
+				job.hydraulicPersistence);
+
+		}
+
+		const HeightField::HydraulicErosionStats& stats = field.GetHydraulicErosionStats();
+
+		printf("%s: %d droplets, %.1f steps each, %d stalled, %d ran off the map, %g eroded, %g deposited\n", job.output.c_str(),
+			stats.droplets, stats.averagePathLength, stats.stalledDroplets, stats.exitedDroplets, stats.sedimentEroded,
+			stats.sedimentDeposited);
+
+	}
+
+	if (job.pipeIterations > 0)
+	{
+
+		field.PipeHydraulicErosion(job.carryingCapacity, job.depositionSpeed, job.pipeIterations, job.rainfall, job.evaporation);
+
+	}
+
+	if (job.meshError > 0.0f)
+	{
+
+		double meshStart = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+		TerrainAdaptiveMesh mesh;
+		mesh.BuildErrors(field);
+		mesh.Triangulate(field, job.meshError);
+
+		double meshSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() - meshStart;
+
+		const TerrainAdaptiveMesh::TriangulationStats& stats = mesh.GetTriangulationStats();
+
+		printf("%s: adaptive mesh has %d triangles (%.1fx fewer than the grid's %d) and %d vertices, max error %g, %.3f s\n",
+			job.output.c_str(), stats.triangles, (double)stats.gridTriangles / std::max(stats.triangles, 1), stats.gridTriangles,
+			stats.vertices, stats.maxError, meshSeconds);
+
+	}
+
+	float minHeight, maxHeight;
+	GetHeightRange(field, minHeight, maxHeight);
+
+	// Either end left out comes from the terrain itself
+	float rangeMin = job.heightMinSet ? job.heightMin : minHeight;
+	float rangeMax = job.heightMaxSet ? job.heightMax : maxHeight;
+
+	bool written;
+
+	if (job.format == "r16")
+	{
+
+		written = WriteHeightMapR16(field, job.output.c_str(), rangeMin, rangeMax);
+
+	}
+	else if (job.format == "pgm")
+	{
+
+		written = WriteHeightMapPGM(field, job.output.c_str(), rangeMin, rangeMax);
+
+	}
+	else
+	{
+
+		written = WriteHeightMapR32(field, job.output.c_str());
+
+	}
+
+	if (!written)
+	{
+
+		fprintf(stderr, "%s: could not write heightmap\n", job.output.c_str());
+		return false;
+
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() - start;
+
+	printf("%s: %dx%d %s, heights %g to %g, %.3f s\n", job.output.c_str(), job.resolution, job.resolution,
+		job.format.c_str(), minHeight, maxHeight, seconds);
+
+	return true;
+
+}
+
+int main(int argc, char** argv)
+{
+
+	int threads = -1;
+	int firstJob = 1;
+
+	if (argc > 2 && strcmp(argv[1], "--threads") == 0)
+	{
+
+		threads = atoi(argv[2]);
+		firstJob = 3;
+
+	}
+
+	if (firstJob >= argc)
+	{
+
+		fprintf(stderr, "Usage: %s [--threads N] job.txt [job2.txt ...]\n", argv[0]);
+		return 1;
+
+	}
+
+	ImprovedNoise perlin;
+	SimplexNoise simplex;
+
+	// Carry on with the remaining jobs if one fails, but report the failure
+	int failed = 0;
+
+	for (int i = firstJob; i < argc; i++)
+	{
+
+		BakeJob job;
+
+		if (!ReadJob(argv[i], job))
+		{
+
+			failed++;
+			continue;
+
+		}
+
+		if (threads >= 0)
+		{
+
+			job.threads = threads;
+
+		}
+
+		if (!RunJob(job, &perlin, &simplex))
+		{
+
+			failed++;
+
+		}
+
+	}
+
+	return failed == 0 ? 0 : 1;
+
+}
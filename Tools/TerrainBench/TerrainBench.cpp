@@ -0,0 +1,491 @@
+// TerrainBench.cpp
+// Headless benchmark for every stage of building a terrain: noise generation, smoothing, thermal and hydraulic erosion,
+// normals and vertex and index building. Runs each stage with fixed parameters and seeds at a range of resolutions and writes one
+// JSON object per line, so results can be collected and compared between releases.
+//
+// Usage: TerrainBench [--min-resolution N] [--max-resolution N] [--threads N] [--output file]
+// Resolutions are powers of two from 128 to 4096 unless limited. Every field is always written, with -1 for metrics
+// that don't apply to a stage:
+//   stage, resolution, threads, repeats, seconds (per run), ns_per_sample (per noise sample), cells_per_second,
+//   droplets_per_second, peak_memory_bytes (peak resident memory of the whole process so far)
+// vertices_update times rebuilding the normals and chunks around a 64x64 edit, and gives cells_per_second over the edit
+// adaptive_mesh times working out the adaptive mesh's errors and triangulating it to within 0.05 of the heights
+//
+// Build with CMake from the repository root (see README.md), or directly, e.g. with GCC or Clang:
+//   g++ -O2 -std=c++11 -pthread -ICode Tools/TerrainBench/TerrainBench.cpp Code/HeightField.cpp Code/TerrainGeometry.cpp
+//     Code/TerrainChunks.cpp Code/TerrainAdaptiveMesh.cpp Code/ThreadPool.cpp Code/ImprovedNoise.cpp Code/SimplexNoise.cpp
+//     Code/NoiseBatch.cpp Code/NoiseSSE41.cpp Code/NoiseAVX2.cpp -o TerrainBench
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "HeightField.h"
+#include "TerrainChunks.h"
+#include "TerrainAdaptiveMesh.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// Fixed settings so runs are comparable
+static const unsigned int BENCH_SEED = 12345;
+static const float BENCH_OFFSET_X = 0.0f;
+static const float BENCH_OFFSET_Z = 0.0f;
+static const float BENCH_FREQUENCY = 0.02f;
+static const float BENCH_AMPLITUDE = 20.0f;
+static const int BENCH_OCTAVES = 8;
+static const float BENCH_PERSISTENCE = 0.5f;
+static const float BENCH_OFFSET_Y = 0.0f;
+static const int BENCH_SMOOTHING_RADIUS = 8;
+static const int BENCH_THERMAL_ITERATIONS = 5;
+static const int BENCH_PYRAMID_LEVELS = 4;
+static const int BENCH_HYDRAULIC_DROPS = 100000;
+static const int BENCH_HYDRAULIC_ITERATIONS = 30;
+static const int BENCH_PIPE_ITERATIONS = 20;
+static const int BENCH_EDIT_SIZE = 64;
+static const float BENCH_ADAPTIVE_ERROR = 0.05f;
+
+// Each stage is repeated until roughly this many cells have been processed, so small resolutions still get a stable time
+static const double BENCH_TARGET_CELLS = 4.0 * 1024.0 * 1024.0;
+
+struct BenchResult
+{
+
+	const char* stage;
+	int resolution;
+	int threads;
+	int repeats;
+	double seconds;
+	double nsPerSample;
+	double cellsPerSecond;
+	double dropletsPerSecond;
+
+};
+
+static double Now()
+{
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+}
+
+// Peak resident memory of the process, 0 if it can't be found
+static long long PeakMemoryBytes()
+{
+
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+
+		return (long long)counters.PeakWorkingSetSize;
+
+	}
+
+	return 0;
+#else
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+
+#ifdef __APPLE__
+		return (long long)usage.ru_maxrss;
+#else
+		return (long long)usage.ru_maxrss * 1024;
+#endif
+
+	}
+
+	return 0;
+#endif
+
+}
+
+static void WriteResult(FILE* output, const BenchResult& result)
+{
+
+	fprintf(output, "{\"stage\":\"%s\",\"resolution\":%d,\"threads\":%d,\"repeats\":%d,\"seconds\":%.9g,"
+		"\"ns_per_sample\":%.6g,\"cells_per_second\":%.6g,\"droplets_per_second\":%.6g,\"peak_memory_bytes\":%lld}\n",
+		result.stage, result.resolution, result.threads, result.repeats, result.seconds,
+		result.nsPerSample, result.cellsPerSecond, result.dropletsPerSecond, PeakMemoryBytes());
+	fflush(output);
+
+}
+
+static int RepeatsFor(double cells)
+{
+
+	int repeats = (int)(BENCH_TARGET_CELLS / cells);
+	return repeats < 1 ? 1 : repeats;
+
+}
+
+static BenchResult MakeResult(const char* stage, const HeightField& field, int repeats, double seconds)
+{
+
+	double cells = (double)field.GetResolution() * field.GetResolution();
+
+	BenchResult result;
+	result.stage = stage;
+	result.resolution = field.GetResolution();
+	result.threads = field.GetThreadCount();
+	result.repeats = repeats;
+	result.seconds = seconds / repeats;
+	result.nsPerSample = -1.0;
+	result.cellsPerSecond = cells / result.seconds;
+	result.dropletsPerSecond = -1.0;
+
+	return result;
+
+}
+
+static void BenchGenerate(FILE* output, HeightField& field, const char* stage, bool ridged, bool simplex)
+{
+
+	double cells = (double)field.GetResolution() * field.GetResolution();
+	int repeats = RepeatsFor(cells);
+
+	double start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.GenerateHeightMap(BENCH_OFFSET_X, BENCH_OFFSET_Z, BENCH_FREQUENCY, BENCH_AMPLITUDE, ridged, simplex,
+			BENCH_OCTAVES, BENCH_PERSISTENCE, BENCH_OFFSET_Y);
+
+	}
+
+	BenchResult result = MakeResult(stage, field, repeats, Now() - start);
+
+	// Ridged terrain samples two planes of noise for every octave
+	double samples = cells * BENCH_OCTAVES * (ridged ? 2.0 : 1.0);
+	result.nsPerSample = result.seconds * 1e9 / samples;
+
+	WriteResult(output, result);
+
+}
+
+static void BenchResolution(FILE* output, ImprovedNoise* perlin, SimplexNoise* simplex, int resolution, int threads)
+{
+
+	HeightField field(perlin, simplex, resolution);
+	field.SetThreadCount(threads);
+
+	double cells = (double)resolution * resolution;
+	double start;
+	int repeats;
+
+	BenchGenerate(output, field, "generate_perlin", false, false);
+	BenchGenerate(output, field, "generate_simplex_ridged", true, true);
+
+	// The remaining stages work on the same Perlin terrain every time
+	field.GenerateHeightMap(BENCH_OFFSET_X, BENCH_OFFSET_Z, BENCH_FREQUENCY, BENCH_AMPLITUDE, false, false,
+		BENCH_OCTAVES, BENCH_PERSISTENCE, BENCH_OFFSET_Y);
+
+	repeats = RepeatsFor(cells);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.SmoothingFunction(0.5f, 1000.0f, -1000.0f);
+
+	}
+
+	WriteResult(output, MakeResult("smoothing", field, repeats, Now() - start));
+
+	field.SetSmoothingDoubleBuffered(true);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.SmoothingFunction(0.5f, 1000.0f, -1000.0f);
+
+	}
+
+	WriteResult(output, MakeResult("smoothing_double_buffered", field, repeats, Now() - start));
+
+	field.SetSmoothingDoubleBuffered(false);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.SeparableSmoothing(SMOOTHING_GAUSSIAN, BENCH_SMOOTHING_RADIUS, 1, 0.5f, 1000.0f, -1000.0f);
+
+	}
+
+	WriteResult(output, MakeResult("smoothing_gaussian", field, repeats, Now() - start));
+
+	repeats = RepeatsFor(cells * BENCH_THERMAL_ITERATIONS);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.ThermalErosion(BENCH_THERMAL_ITERATIONS);
+
+	}
+
+	BenchResult thermal = MakeResult("thermal_erosion", field, repeats, Now() - start);
+	thermal.cellsPerSecond *= BENCH_THERMAL_ITERATIONS;
+	WriteResult(output, thermal);
+
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.ParallelThermalErosion(BENCH_THERMAL_ITERATIONS);
+
+	}
+
+	BenchResult parallelThermal = MakeResult("thermal_erosion_parallel", field, repeats, Now() - start);
+	parallelThermal.cellsPerSecond *= BENCH_THERMAL_ITERATIONS;
+	WriteResult(output, parallelThermal);
+
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.PyramidThermalErosion(BENCH_THERMAL_ITERATIONS, BENCH_PYRAMID_LEVELS);
+
+	}
+
+	BenchResult pyramidThermal = MakeResult("thermal_erosion_pyramid", field, repeats, Now() - start);
+	pyramidThermal.cellsPerSecond *= BENCH_THERMAL_ITERATIONS;
+	WriteResult(output, pyramidThermal);
+
+	// Droplets are placed with rand(), so reseed for the same drops every run
+	srand(BENCH_SEED);
+	start = Now();
+	field.HydraulicErosion(0.5f, 0.1f, BENCH_HYDRAULIC_ITERATIONS, BENCH_HYDRAULIC_DROPS, 0.9f);
+
+	BenchResult hydraulic = MakeResult("hydraulic_erosion", field, 1, Now() - start);
+	hydraulic.cellsPerSecond = -1.0;
+	hydraulic.dropletsPerSecond = BENCH_HYDRAULIC_DROPS / hydraulic.seconds;
+	WriteResult(output, hydraulic);
+
+	start = Now();
+	field.ParallelHydraulicErosion(0.5f, 0.1f, BENCH_HYDRAULIC_ITERATIONS, BENCH_HYDRAULIC_DROPS, 0.9f, BENCH_SEED);
+
+	BenchResult parallelHydraulic = MakeResult("hydraulic_erosion_parallel", field, 1, Now() - start);
+	parallelHydraulic.cellsPerSecond = -1.0;
+	parallelHydraulic.dropletsPerSecond = BENCH_HYDRAULIC_DROPS / parallelHydraulic.seconds;
+	WriteResult(output, parallelHydraulic);
+
+	repeats = RepeatsFor(cells * BENCH_PIPE_ITERATIONS);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.PipeHydraulicErosion(0.5f, 0.1f, BENCH_PIPE_ITERATIONS, 0.01f, 0.5f);
+
+	}
+
+	BenchResult pipeHydraulic = MakeResult("hydraulic_erosion_pipe", field, repeats, Now() - start);
+	pipeHydraulic.cellsPerSecond *= BENCH_PIPE_ITERATIONS;
+	WriteResult(output, pipeHydraulic);
+
+	repeats = RepeatsFor(cells);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.CalculateNormals();
+
+	}
+
+	WriteResult(output, MakeResult("normals", field, repeats, Now() - start));
+
+	TerrainVertex* vertices = new TerrainVertex[GetTerrainVertexCount(resolution)];
+	unsigned int* indices = new unsigned int[GetTerrainIndexCount(resolution)];
+
+	repeats = RepeatsFor(cells);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		BuildTerrainVertices(field, vertices);
+
+	}
+
+	WriteResult(output, MakeResult("vertices", field, repeats, Now() - start));
+
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		BuildTerrainIndices(resolution, indices);
+
+	}
+
+	WriteResult(output, MakeResult("indices", field, repeats, Now() - start));
+
+	// A local edit in the middle of the terrain, the normals and chunks around it are all that need rebuilding
+	int edit = BENCH_EDIT_SIZE < resolution - 2 ? BENCH_EDIT_SIZE : resolution - 2;
+	int editBegin = (resolution - edit) / 2;
+	double editCells = (double)edit * edit;
+
+	TerrainChunks chunks;
+	chunks.Layout(resolution);
+	TerrainVertex* chunkVertices = new TerrainVertex[chunks.GetVertexCount()];
+
+	// Every chunk's vertices, skirts and level of detail errors
+	repeats = RepeatsFor(cells);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		for (int c = 0; c < chunks.GetChunkCount(); c++)
+		{
+
+			chunks.BuildChunk(field, c, chunkVertices);
+
+		}
+
+	}
+
+	WriteResult(output, MakeResult("chunks", field, repeats, Now() - start));
+
+	repeats = RepeatsFor(editCells);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		field.CalculateNormals(editBegin, editBegin + edit, editBegin, editBegin + edit);
+		chunks.MarkDirty(editBegin, editBegin + edit, editBegin, editBegin + edit);
+
+		for (int c = 0; c < chunks.GetChunkCount(); c++)
+		{
+
+			if (chunks.GetChunk(c).dirty)
+			{
+
+				chunks.BuildChunk(field, c, chunkVertices);
+
+			}
+
+		}
+
+	}
+
+	BenchResult update = MakeResult("vertices_update", field, repeats, Now() - start);
+	update.cellsPerSecond = editCells / update.seconds;
+	WriteResult(output, update);
+
+	// Everything the adaptive mesh needs after the heights change
+	TerrainAdaptiveMesh adaptive;
+
+	repeats = RepeatsFor(cells);
+	start = Now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+
+		adaptive.BuildErrors(field);
+		adaptive.Triangulate(field, BENCH_ADAPTIVE_ERROR);
+
+	}
+
+	WriteResult(output, MakeResult("adaptive_mesh", field, repeats, Now() - start));
+
+	delete[] vertices;
+	delete[] indices;
+	delete[] chunkVertices;
+
+}
+
+int main(int argc, char** argv)
+{
+
+	int minResolution = 128;
+	int maxResolution = 4096;
+	int threads = 0;
+	FILE* output = stdout;
+
+	for (int i = 1; i < argc; i++)
+	{
+
+		if (strcmp(argv[i], "--min-resolution") == 0 && i + 1 < argc)
+		{
+
+			minResolution = atoi(argv[++i]);
+
+		}
+		else if (strcmp(argv[i], "--max-resolution") == 0 && i + 1 < argc)
+		{
+
+			maxResolution = atoi(argv[++i]);
+
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+
+			threads = atoi(argv[++i]);
+
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+
+			output = fopen(argv[++i], "w");
+
+			if (output == 0)
+			{
+
+				fprintf(stderr, "Could not open %s for writing\n", argv[i]);
+				return 1;
+
+			}
+
+		}
+		else
+		{
+
+			fprintf(stderr, "Usage: %s [--min-resolution N] [--max-resolution N] [--threads N] [--output file]\n", argv[0]);
+			return 1;
+
+		}
+
+	}
+
+	ImprovedNoise perlin;
+	SimplexNoise simplex;
+
+	for (int resolution = 128; resolution <= maxResolution; resolution *= 2)
+	{
+
+		if (resolution >= minResolution)
+		{
+
+			BenchResolution(output, &perlin, &simplex, resolution, threads);
+
+		}
+
+	}
+
+	if (output != stdout)
+	{
+
+		fclose(output);
+
+	}
+
+	return 0;
+
+}